@@ -0,0 +1,17 @@
+#ifndef DPA_MATH_CAUCHY_GREEN_FTLE_HPP
+#define DPA_MATH_CAUCHY_GREEN_FTLE_HPP
+
+#include <cstddef>
+
+#include <dpa/types/basic_types.hpp>
+
+namespace dpa
+{
+// The FTLE log(sqrt(lambda_max)) * inverse_time of count right Cauchy-Green tensors, given as arrays of their upper
+// triangles. The only translation unit compiled with -ffast-math (see CMakeLists.txt), such that the loop over
+// largest_symmetric_eigenvalue vectorizes. As it assumes finite values, the eigenvalue is clamped to the smallest
+// normal scalar, i.e. degenerate tensors yield a large negative FTLE rather than -inf.
+void cauchy_green_ftle(const scalar* c00, const scalar* c01, const scalar* c02, const scalar* c11, const scalar* c12, const scalar* c22, const std::size_t count, const scalar inverse_time, scalar* output);
+}
+
+#endif
@@ -2,59 +2,117 @@
 #define DPA_MATH_PERMUTE_FOR_HPP
 
 #include <cstddef>
-#include <functional>
+#include <tuple>
+#include <type_traits>
 
 #include <tbb/tbb.h>
 
 namespace dpa
 {
-// Ducks [] and .size() on the type.
-template <typename type>
+// Ducks [] and std::tuple_size on the type. The loops over the dimensions from depth on are unrolled at compile time, the
+// last dimension being the innermost loop.
+template <std::size_t depth, typename type, typename function_type>
+void permute_for_internal(
+  const function_type& function,
+  type&                indices ,
+  const type&          start   ,
+  const type&          end     ,
+  const type&          step    )
+{
+  if constexpr (depth < std::tuple_size<type>::value)
+  {
+    for (auto i = start[depth]; i < end[depth]; i += step[depth])
+    {
+      indices[depth] = i;
+      permute_for_internal<depth + 1>(function, indices, start, end, step);
+    }
+  }
+  else
+    function(static_cast<const type&>(indices));
+}
+
+// Ducks [] and std::tuple_size on the type.
+template <typename type, typename function_type>
 void permute_for(
-  const std::function<void(const type&)>& function, 
-  const type&                             start   ,
-  const type&                             end     ,
-  const type&                             step    )
+  const function_type& function,
+  const type&          start   ,
+  const type&          end     ,
+  const type&          step    )
+{
+  type indices {};
+  permute_for_internal<0>(function, indices, start, end, step);
+}
+
+// Ducks [] and std::tuple_size on the type. Up to the first three dimensions are partitioned by a blocked_range(2d|3d),
+// the others (and the last dimension of each block, contiguous for row-major data) are iterated serially within a task.
+template <typename type, typename function_type>
+void parallel_permute_for(
+  const function_type& function,
+  const type&          start   ,
+  const type&          end     ,
+  const type&          step    )
 {
-  std::function<void(type, std::size_t)> permute_for_internal =
-    [&] (type indices, std::size_t depth)
+  using value_type = std::decay_t<decltype(start[0])>;
+
+  constexpr auto dimensions = std::tuple_size<type>::value;
+  const auto     count      = [&] (const std::size_t dimension)
+  {
+    return end[dimension] > start[dimension] ? (end[dimension] - start[dimension] + step[dimension] - 1) / step[dimension] : value_type(0);
+  };
+  const auto     at         = [&] (const std::size_t dimension, const value_type i)
+  {
+    return static_cast<value_type>(start[dimension] + i * step[dimension]);
+  };
+
+  if constexpr (dimensions == 1)
+  {
+    tbb::parallel_for(tbb::blocked_range<value_type>(0, count(0)), [&] (const tbb::blocked_range<value_type>& range)
     {
-      if (depth < start.size())
+      type indices {};
+      for (auto i = range.begin(); i != range.end(); ++i)
       {
-        for (auto i = start[depth]; i < end[depth]; i += step[depth])
+        indices[0] = at(0, i);
+        function(static_cast<const type&>(indices));
+      }
+    });
+  }
+  else if constexpr (dimensions == 2)
+  {
+    tbb::parallel_for(tbb::blocked_range2d<value_type>(0, count(0), 0, count(1)), [&] (const tbb::blocked_range2d<value_type>& range)
+    {
+      type indices {};
+      for (auto i = range.rows().begin(); i != range.rows().end(); ++i)
+      {
+        indices[0] = at(0, i);
+        for (auto j = range.cols().begin(); j != range.cols().end(); ++j)
         {
-          indices[depth] = i;
-          permute_for_internal(indices, depth + 1);
+          indices[1] = at(1, j);
+          function(static_cast<const type&>(indices));
         }
       }
-      else
-        function(indices);
-    };
-  permute_for_internal(type(), 0);
-}
-
-// Ducks [] and .size() on the type.
-template <typename type>
-void parallel_permute_for(
-  const std::function<void(const type&)>& function, 
-  const type&                             start   ,
-  const type&                             end     ,
-  const type&                             step    )
-{
-  std::function<void(type, std::size_t)> permute_for_internal =
-    [&] (type indices, std::size_t depth)
+    });
+  }
+  else
+  {
+    tbb::parallel_for(tbb::blocked_range3d<value_type>(0, count(0), 0, count(1), 0, count(2)), [&] (const tbb::blocked_range3d<value_type>& range)
     {
-      if (depth < start.size())
-        tbb::parallel_for(start[depth], end[depth], step[depth], [&] (const std::size_t index)
+      type indices {};
+      for (auto i = range.pages().begin(); i != range.pages().end(); ++i)
+      {
+        indices[0] = at(0, i);
+        for (auto j = range.rows().begin(); j != range.rows().end(); ++j)
         {
-          indices[depth] = index;
-          permute_for_internal(indices, depth + 1);
-        });
-      else
-        function(indices);
-    };
-  permute_for_internal(type(), 0);
+          indices[1] = at(1, j);
+          for (auto k = range.cols().begin(); k != range.cols().end(); ++k)
+          {
+            indices[2] = at(2, k);
+            permute_for_internal<3>(function, indices, start, end, step);
+          }
+        }
+      }
+    });
+  }
 }
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,39 @@
+#ifndef DPA_MATH_SYMMETRIC_EIGENVALUES_HPP
+#define DPA_MATH_SYMMETRIC_EIGENVALUES_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <dpa/types/basic_types.hpp>
+
+namespace dpa
+{
+// The largest eigenvalue of the symmetric matrix [[a00, a01, a02], [a01, a11, a12], [a02, a12, a22]], from the
+// trigonometric solution of its characteristic polynomial (Smith, 1961). Free of data-dependent branches such that
+// loops over it vectorize (given the vector variants of the math functions, see cauchy_green_ftle); a (numerically)
+// scaled identity yields its diagonal element as p vanishes. The matrix is scaled by its largest coefficient first (as
+// in Eigen's SelfAdjointEigenSolver), such that the squares below neither overflow nor underflow. Within 1e-5 relative
+// error of the solver, except for a repeated largest eigenvalue, which is ill-conditioned in r (about 1e-4).
+inline scalar largest_symmetric_eigenvalue(scalar a00, scalar a01, scalar a02, scalar a11, scalar a12, scalar a22)
+{
+  const auto scale         = std::max({std::abs(a00), std::abs(a01), std::abs(a02), std::abs(a11), std::abs(a12), std::abs(a22)});
+  const auto inverse_scale = scalar(1) / std::max(scale, std::numeric_limits<scalar>::min());
+  a00 *= inverse_scale; a01 *= inverse_scale; a02 *= inverse_scale;
+  a11 *= inverse_scale; a12 *= inverse_scale; a22 *= inverse_scale;
+
+  const auto q   = (a00 + a11 + a22) / scalar(3);
+  const auto b00 = a00 - q, b11 = a11 - q, b22 = a22 - q;
+  const auto p   = std::sqrt((b00 * b00 + b11 * b11 + b22 * b22 + scalar(2) * (a01 * a01 + a02 * a02 + a12 * a12)) / scalar(6));
+
+  // The determinant of (A - qI) / p, halved.
+  const auto inverse_p = scalar(1) / std::max(p, std::numeric_limits<scalar>::min());
+  const auto c00 = b00 * inverse_p, c11 = b11 * inverse_p, c22 = b22 * inverse_p;
+  const auto c01 = a01 * inverse_p, c02 = a02 * inverse_p, c12 = a12 * inverse_p;
+  const auto r   = scalar(0.5) * (c00 * (c11 * c22 - c12 * c12) - c01 * (c01 * c22 - c12 * c02) + c02 * (c01 * c12 - c11 * c02));
+
+  return scale * (q + scalar(2) * p * std::cos(std::acos(std::clamp(r, scalar(-1), scalar(1))) / scalar(3)));
+}
+}
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef DPA_STAGES_COLOR_GENERATOR_HPP
 #define DPA_STAGES_COLOR_GENERATOR_HPP
 
+#include <dpa/stages/domain_partitioner.hpp>
 #include <dpa/types/integral_curves.hpp>
 #include <dpa/types/regular_fields.hpp>
 #include <dpa/types/relative_direction.hpp>
@@ -13,7 +14,9 @@ public:
   static void generate_from_tangents          (integral_curves& integral_curves);
   static void generate_from_angular_velocities(integral_curves& integral_curves);
   static void generate_from_velocities        (integral_curves& integral_curves, const std::unordered_map<relative_direction, regular_vector_field_3d>& vector_fields);
-  static void generate_from_potentials        (integral_curves& integral_curves, const std::unordered_map<relative_direction, regular_vector_field_3d>& vector_fields);
+  // Given the partitioner, the potential is continuous across the ranks (see regular_grid::potential), based on the
+  // center block only, hence vertices beyond it (of load balanced particles) are not colored.
+  static void generate_from_potentials        (integral_curves& integral_curves, const std::unordered_map<relative_direction, regular_vector_field_3d>& vector_fields, domain_partitioner* partitioner = nullptr);
 };
 }
 
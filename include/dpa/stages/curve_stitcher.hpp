@@ -0,0 +1,20 @@
+#ifndef DPA_STAGES_CURVE_STITCHER_HPP
+#define DPA_STAGES_CURVE_STITCHER_HPP
+
+#include <boost/mpi/communicator.hpp>
+
+#include <dpa/types/integral_curves.hpp>
+
+namespace dpa
+{
+class curve_stitcher
+{
+public:
+  // Collective. Sends each polyline (one per particle and round) to the rank owning its particle id (id modulo the
+  // number of ranks), where the segments of each particle are sorted and concatenated into a single polyline. Returns
+  // one curve of complete polylines in ascending id order, with indices and (if all ranks had them) scalar colors.
+  static integral_curves stitch(const integral_curves& integral_curves, const boost::mpi::communicator& communicator, const bool use_64_bit_indices = false);
+};
+}
+
+#endif
@@ -36,6 +36,7 @@ public:
   boost::mpi::communicator*                                communicator          ();
   boost::mpi::cartesian_communicator*                      cartesian_communicator();
   const svector3&                                          domain_size           () const;
+  const svector3&                                          ghost_cell_size       () const;
   const svector3&                                          grid_size             () const;
   const svector3&                                          block_size            () const;
   const std::unordered_map<relative_direction, partition>& partitions            () const;
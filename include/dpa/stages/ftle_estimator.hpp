@@ -3,11 +3,15 @@
 
 #include <tbb/tbb.h>
 
+#include <dpa/stages/domain_partitioner.hpp>
 #include <dpa/types/particle.hpp>
+#include <dpa/types/point_cloud.hpp>
 #include <dpa/types/regular_fields.hpp>
 
 namespace dpa
 {
+// The flow map consists of the positions of the local particles. For the field of an FTLE horizon, these are the
+// particles snapshot at it (particle_advector::output::horizon_particles) and the seed iterations are those of the horizon.
 class ftle_estimator
 {
 public:
@@ -17,6 +21,69 @@ public:
     const vector3&                             seed_stride            , 
     const scalar                               step_size              , 
     const tbb::concurrent_vector<particle_3d>& local_particles        );
+
+  // Collective alternative to estimate which does not require the particles to be gathered to their original ranks.
+  // The final positions are counting-sorted by original rank and exchanged in a single MPI_Alltoallv, scattered into
+  // the strided flow map of the (non-ghosted) block, and a one cell halo of the flow map is exchanged with the face
+  // neighbors such that the gradient is central across ranks (one-sided at the domain boundaries only). The FTLE field
+  // has the (ghosted) layout of estimate, of which the strided cells of the block are computed.
+  static regular_scalar_field_3d estimate_distributed(
+    domain_partitioner*                        partitioner            ,
+    const regular_vector_field_3d&             original_vector_field  , 
+    const std::size_t                          seed_maximum_iterations, 
+    const vector3&                             seed_stride            , 
+    const scalar                               step_size              , 
+    const tbb::concurrent_vector<particle_3d>& local_particles        );
+
+  // Flow map composition approximates the flow map of a multiple of the integration time without advecting for it. The
+  // strided flow map of the whole domain is assembled on all ranks in a single MPI_Allgatherv (gather_flow_map, which
+  // does not require gathered particles and throws std::overflow_error beyond INT_MAX particles), as a composed
+  // position may reach any cell of the domain. Its restriction to the block padded by a one cell halo is extracted
+  // (block_flow_map) and advanced by repeated (trilinearly interpolated) application of the global map (compose). The
+  // FTLE of the result is estimated as by estimate_distributed (estimate_block). The error of the interpolation is
+  // measured against a directly advected map by compare: the maximum and root mean square distance over all blocks.
+  struct composition_error
+  {
+    scalar maximum         ;
+    scalar root_mean_square;
+  };
+
+  static regular_vector_field_3d gather_flow_map(
+    domain_partitioner*                        partitioner            ,
+    const regular_vector_field_3d&             original_vector_field  , 
+    const vector3&                             seed_stride            , 
+    const tbb::concurrent_vector<particle_3d>& local_particles        );
+  static regular_vector_field_3d block_flow_map(
+    domain_partitioner*                        partitioner            ,
+    const regular_vector_field_3d&             original_vector_field  , 
+    const vector3&                             seed_stride            , 
+    const regular_vector_field_3d&             global_flow_map        );
+  // Returns global_flow_map(flow_map(x)) for each cell x of the flow map. Positions outside the global flow map are held,
+  // as particles leaving the domain are.
+  static regular_vector_field_3d compose(
+    const regular_vector_field_3d&             flow_map               ,
+    const regular_vector_field_3d&             global_flow_map        );
+  static regular_scalar_field_3d estimate_block(
+    domain_partitioner*                        partitioner            ,
+    const regular_vector_field_3d&             original_vector_field  , 
+    const std::size_t                          iterations             , 
+    const vector3&                             seed_stride            , 
+    const scalar                               step_size              , 
+    const regular_vector_field_3d&             flow_map               );
+  // Collective. Both flow maps are block flow maps.
+  static composition_error       compare(
+    domain_partitioner*                        partitioner            ,
+    const regular_vector_field_3d&             lhs_flow_map           ,
+    const regular_vector_field_3d&             rhs_flow_map           );
+
+  // Alternative to estimate from the deformation gradients integrated along the trajectories (see particle_advector's
+  // integrate_deformation), which requires neither neighbors nor a seed grid, hence neither gathering nor communication.
+  // Returns the FTLE of each particle at its original position, over the iterations it completed (zero for those which
+  // completed none).
+  static point_cloud             estimate_from_deformations(
+    const std::size_t                          seed_maximum_iterations, 
+    const scalar                               step_size              , 
+    const tbb::concurrent_vector<particle_3d>& local_particles        );
 };
 }
 
@@ -0,0 +1,45 @@
+#ifndef DPA_STAGES_INTEGRAL_CURVE_READER_HPP
+#define DPA_STAGES_INTEGRAL_CURVE_READER_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <dpa/types/basic_types.hpp>
+#include <dpa/types/integral_curves.hpp>
+#include <dpa/utility/spatial_index.hpp>
+
+namespace dpa
+{
+// Reads region queries from a per-rank file written by integral_curve_saver::save with a spatial index. Only the chunks
+// intersecting the query box are read (contiguous ones with one hyperslab per dataset).
+class integral_curve_reader
+{
+public:
+  struct indexed_curve
+  {
+    std::size_t                index ; // The suffix of the datasets of the curve.
+    std::vector<spatial_chunk> chunks;
+  };
+
+  // Reads the spatial indices of all curves of the file.
+  explicit integral_curve_reader  (const std::string& filepath);
+  integral_curve_reader           (const integral_curve_reader&  that) = default;
+  integral_curve_reader           (      integral_curve_reader&& temp) = default;
+ ~integral_curve_reader           ()                                   = default;
+  integral_curve_reader& operator=(const integral_curve_reader&  that) = default;
+  integral_curve_reader& operator=(      integral_curve_reader&& temp) = default;
+
+  const std::vector<indexed_curve>& curves() const;
+
+  // Returns one curve per curve of the file, consisting of the polylines of its chunks intersecting the box. Polylines
+  // are complete, hence may extend beyond the box. Indices are relative to the returned vertices.
+  integral_curves                   read  (const aabb3& box) const;
+
+protected:
+  std::string                filepath_ = {};
+  std::vector<indexed_curve> curves_   = {};
+};
+}
+
+#endif
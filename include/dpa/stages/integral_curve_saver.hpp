@@ -1,29 +1,84 @@
 #ifndef DPA_STAGES_INTEGRAL_CURVE_SAVER_HPP
 #define DPA_STAGES_INTEGRAL_CURVE_SAVER_HPP
 
+#include <future>
+#include <optional>
 #include <string>
+#include <vector>
+
+#include <hdf5.h>
 
 #include <dpa/stages/domain_partitioner.hpp>
 #include <dpa/types/integral_curves.hpp>
+#include <dpa/utility/hdf5_compression.hpp>
+#include <dpa/utility/spatial_index.hpp>
 
 namespace dpa
 {
 class integral_curve_saver
 {
 public:
-  explicit integral_curve_saver  (domain_partitioner* partitioner, const std::string& filepath);
+  // The compression is "none", "deflate" or "lz4". If mantissa bits are given, vertices are rounded to them (lossy).
+  // If spatial_index is set, save sorts the polylines of each curve by the morton code of their bounding box centers
+  // and additionally writes the bounds and ranges of runs of them (see spatial_chunk), read by integral_curve_reader.
+  // save_shared and append (streaming) write the curves unsorted and without index.
+  explicit integral_curve_saver  (domain_partitioner* partitioner, const std::string& filepath, const std::string& compression = "none", const std::optional<size>& mantissa_bits = std::nullopt, const bool spatial_index = false);
   integral_curve_saver           (const integral_curve_saver&  that) = delete ;
   integral_curve_saver           (      integral_curve_saver&& temp) = default;
  ~integral_curve_saver           ()                                  = default;
   integral_curve_saver& operator=(const integral_curve_saver&  that) = delete ;
   integral_curve_saver& operator=(      integral_curve_saver&& temp) = default;
 
-  void save(const integral_curves& integral_curves);
+  void save      (const integral_curves& integral_curves);
+  // Collective alternative to save: all ranks write into one vertices, colors and indices dataset of a single file
+  // (described by a single XDMF file) through MPI-IO, at the offsets of their exclusive scans. Indices are rebased.
+  void save_shared(const integral_curves& integral_curves);
+
+  // Streaming alternative to save: each call appends the curves (of a round) to extendible chunked datasets on a
+  // background thread, and returns once the previous call's write is complete, such that writing overlaps with the
+  // advection of the next round. The curves are released once written. Call finalize after the last round.
+  void save_async(integral_curves&& integral_curves);
+  void finalize  ();
+
+  // Accumulated over all saves. Complete after save, save_shared or finalize.
+  const compression_statistics& statistics() const;
 
 protected:
-  domain_partitioner* partitioner_ = {};
-  std::string         filepath_    = {};
+  struct range
+  {
+    std::size_t index        ;
+    hsize_t     vertex_offset;
+    hsize_t     vertex_count ;
+    hsize_t     color_offset ;
+    hsize_t     color_count  ;
+    hsize_t     index_offset ;
+    hsize_t     index_count  ;
+  };
+
+  void           append          (const integral_curves& integral_curves);
+  // The vertices as floats, decoded and / or rounded into the buffer if necessary.
+  const float*   vertex_data     (const integral_curve& curve, std::vector<float>& buffer) const;
+  // A copy of the curve with its polylines in morton order, and the chunks of them. Indices are regenerated.
+  integral_curve spatially_sorted(const integral_curve& curve, std::vector<spatial_chunk>& chunks) const;
+
+  domain_partitioner*    partitioner_        = {};
+  std::string            filepath_           = {};
+  std::string            shared_filepath_    = {};
+  compression            compression_        = compression::none;
+  std::optional<size>    mantissa_bits_      = {};
+  bool                   spatial_index_      = false;
+  compression_statistics statistics_         = {};
+
+  std::future<void>      pending_            = {};
+  hid_t                  file_               = -1;
+  hid_t                  vertices_dataset_   = -1;
+  hid_t                  colors_dataset_     = -1;
+  hid_t                  indices_dataset_    = -1;
+  bool                   use_scalar_colors_  = true ;
+  bool                   use_64_bit_indices_ = false;
+  std::size_t            curve_count_        = 0;
+  std::vector<range>     ranges_             = {};
 };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -1,7 +1,9 @@
 #ifndef DPA_STAGES_PARTICLE_ADVECTOR_HPP
 #define DPA_STAGES_PARTICLE_ADVECTOR_HPP
 
+#include <algorithm>
 #include <cstddef>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -14,6 +16,7 @@
 #include <dpa/types/integrators.hpp>
 #include <dpa/types/particle.hpp>
 #include <dpa/types/regular_fields.hpp>
+#include <dpa/utility/numa_arenas.hpp>
 
 namespace dpa
 {
@@ -28,6 +31,19 @@ public:
   using concurrent_particle_vector = tbb::concurrent_vector<particle_3d>;
   using concurrent_particle_map    = std::unordered_map    <relative_direction, concurrent_particle_vector>;
   using round_vector               = std::vector           <std::pair<std::reference_wrapper<particle_vector>, std::size_t>>;
+  using attribute_vector           = std::vector           <scalar, allocator<scalar>>;
+
+  // Unsteady (pathline) advection within the interval between the time slice of the vector fields of the state and the
+  // next one: vectors are interpolated linearly in time, and particles advance up to the step at which the interval ends,
+  // upon which they pause (see state::paused_particles) until the next interval. Particles are seeded at time zero.
+  struct time_interval
+  {
+    const vector_field_map* next_vector_fields = nullptr;
+    std::size_t             seed_iterations    = 0; // The step of a particle is seed_iterations - remaining_iterations.
+    std::size_t             end_step           = 0;
+    scalar                  begin_time         = 0;
+    scalar                  duration           = 0; // The time between the slices.
+  };
 
   struct state
   {
@@ -51,10 +67,17 @@ public:
         count += entry.second.size();
       return count;
     }
+    // The remaining iterations at which particles pause, i.e. zero unless unsteady.
+    std::size_t pause_remaining_iterations () const
+    {
+      return interval ? interval->seed_iterations - std::min(interval->end_step, interval->seed_iterations) : 0;
+    }
     
-    const vector_field_map&    vector_fields;
-    particle_vector&           active_particles;
-    particle_map               load_balanced_active_particles {};
+    const vector_field_map&      vector_fields;
+    particle_vector&             active_particles;
+    particle_map                 load_balanced_active_particles {};
+    std::optional<time_interval> interval                       {};
+    concurrent_particle_vector   paused_particles               {};
   };
   struct round_state
   {
@@ -76,16 +99,24 @@ public:
     round_state& operator=(      round_state&& temp) = default;
 
     std::size_t                particle_count                        = 0;
-    std::size_t                curve_stride                          = 0;
-    std::size_t                vertex_count                          = 0;
+    std::size_t                vertex_count                          = 0; // Allocated for the curves of the round.
+    std::size_t                strided_vertex_count                  = 0; // Had every curve been allocated for the longest one.
+    std::vector<std::size_t>   curve_offsets                         {};  // Exclusive prefix sum of the capacities of the curves.
+    std::vector<std::size_t>   curve_sizes                           {};  // Vertices actually recorded per curve.
+    std::vector<std::size_t>   step_counts                           {};  // Vertices per curve had every step been recorded.
+    std::vector<std::uint64_t> curve_ids                             {};  // Particle id and segment of each curve.
+    std::vector<std::uint32_t> curve_segments                        {};
+    attribute_vector           curve_attributes                      {};  // Per vertex, at the same offsets as the vertices.
     round_vector               round_particles                       {};
     concurrent_particle_map    out_of_bounds_particles               {};
     concurrent_particle_map    load_balanced_out_of_bounds_particles {};
   };
   struct output
   {
-    concurrent_particle_vector inactive_particles                    {};
-    dpa::integral_curves       integral_curves                       {};
+    concurrent_particle_vector              inactive_particles       {};
+    dpa::integral_curves                    integral_curves          {};
+    // Per horizon, the particles as they completed it, or as they terminated before reaching it (see deactivate).
+    std::vector<concurrent_particle_vector> horizon_particles        {};
   };
 
   struct load_balancing_info
@@ -120,15 +151,44 @@ public:
     diffuse_lesser_average,
     diffuse_greater_limited_lesser_average
   };
+  enum class attribute
+  {
+    none,
+    angular_velocity,
+    velocity
+  };
+  enum class recording
+  {
+    all,
+    every_nth,
+    arc_length,
+    simplified
+  };
+  enum class interpolation
+  {
+    linear,
+    cubic
+  };
 
   explicit particle_advector  (
-    domain_partitioner* partitioner        , 
-    const size          particles_per_round, 
-    const std::string&  load_balancer      , 
-    const std::string&  integrator         , 
-    const scalar        step_size          , 
-    const bool          gather_particles   , 
-    const bool          record             );
+    domain_partitioner*      partitioner           , 
+    const size               particles_per_round   , 
+    const std::string&       load_balancer         , 
+    const std::string&       integrator            , 
+    const scalar             step_size             , 
+    const bool               gather_particles      , 
+    const bool               record                ,
+    const bool               huge_pages            = false   , // Integral curves are allocated on huge pages.
+    numa_arenas*             arenas                = nullptr , // Particles are advected within the arena of the node which placed their slab.
+    const bool               generate_indices      = false   , // Indices of the curves are generated while pruning, replacing the index_generator.
+    const bool               use_64_bit_indices    = false   ,
+    const std::string&       attribute             = "none"  , // "angular_velocity" or "velocity" colors are computed during advection, replacing the color_generator.
+    const std::string&       recording             = "all"   , // "every_nth" step, "arc_length" spaced or "simplified" vertices, by the parameter (N, length, epsilon).
+    const scalar             recording_parameter   = 1       ,
+    const bool               quantize              = false   , // Curves are held quantized (see integral_curve::quantize) after each round.
+    const std::vector<size>& horizons              = {}      , // Remaining iterations (descending) at which particles are snapshot into output::horizon_particles.
+    const bool               integrate_deformation = false   , // The deformation gradient of each particle is integrated along (see particle::deformation), given DPA_DEFORMATION_SUPPORT.
+    const std::string&       interpolation         = "linear"); // "cubic" (Catmull-Rom) interpolation requires a ghost width of 3 (see interpolation_bounds).
   particle_advector           (const particle_advector&  that) = delete ;
   particle_advector           (      particle_advector&& temp) = default;
  ~particle_advector           ()                               = default;
@@ -143,20 +203,48 @@ protected:
   bool        check_completion        (const state& state) const;
   void        load_balance_distribute (      state& state);
   round_state compute_round_state     (      state& state);
-  void        allocate_integral_curves(                    const round_state& round_state, output& output);
+  void        allocate_integral_curves(                          round_state& round_state, output& output);
   void        advect                  (      state& state,       round_state& round_state, output& output);
   void        load_balance_collect    (      state& state,       round_state& round_state, output& output);
   void        out_of_bounds_distribute(      state& state, const round_state& round_state);
   void        gather_particles        (                                                    output& output);
-  void        prune_integral_curves   (                                                    output& output);
-
-  domain_partitioner*        partitioner_         {};
-  size                       particles_per_round_ {};
-  load_balancer              load_balancer_       {};
-  variant_vector3_integrator integrator_          {};
-  scalar                     step_size_           {};
-  bool                       gather_particles_    {};
-  bool                       record_              {};
+  // Moves the paused particles to the active ones for the next time interval, or to the inactive ones if terminating.
+  void        resume_paused_particles (      state& state,                                 output& output, const bool terminate);
+  void        prune_integral_curves   (              const round_state& round_state, output& output);
+  // Moves a terminated particle to the inactive ones, and to the horizon particles of each horizon it has not reached.
+  // Thread-safe once the horizon particles are sized to the horizons.
+  void        deactivate              (const particle_3d& particle,                        output& output) const;
+
+  // The region within which particles are advected on the block of the vector field, beyond which they are handed over.
+  // Cubic interpolation requires the elements around the cell of a position, hence with a ghost width of 3 the region
+  // excludes the outermost cell of the block (except at the domain boundary, where the stencil is clamped) and the
+  // regions of adjacent blocks still overlap or abut.
+  aabb3       interpolation_bounds    (const regular_vector_field_3d& vector_field) const;
+  bool        interpolation_contains  (const regular_vector_field_3d& vector_field, const aabb3& bounds, const vector3& position) const;
+  // The neighbor to hand a particle over to, if any, i.e. if the position is beyond the bounds.
+  std::optional<relative_direction> out_of_bounds_direction(const aabb3& bounds, const vector3& position) const;
+  vector3     interpolate             (const regular_vector_field_3d& vector_field, const vector3& position) const;
+
+  domain_partitioner*                  partitioner_            {};
+  size                                 particles_per_round_    {};
+  load_balancer                        load_balancer_          {};
+  variant_vector3_integrator           integrator_             {};
+  scalar                               step_size_              {};
+  bool                                 gather_particles_       {};
+  bool                                 record_                 {};
+  bool                                 huge_pages_             {};
+  numa_arenas*                         arenas_                 {};
+  bool                                 generate_indices_       {};
+  bool                                 use_64_bit_indices_     {};
+  attribute                            attribute_              {};
+  recording                            recording_              {};
+  scalar                               recording_parameter_    {};
+  bool                                 quantize_               {};
+  std::vector<size>                    horizons_               {};
+  bool                                 integrate_deformation_  {};
+  variant_flattened_matrix3_integrator deformation_integrator_ {};
+  interpolation                        interpolation_          {};
+  bool                                 cell_stepping_          {};
 };
 }
 
@@ -1,8 +1,13 @@
 #ifndef DPA_STAGES_REGULAR_GRID_LOADER_HPP
 #define DPA_STAGES_REGULAR_GRID_LOADER_HPP
 
+#include <array>
+#include <cstdint>
+#include <future>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <hdf5.h>
 
@@ -10,13 +15,37 @@
 #include <dpa/types/basic_types.hpp>
 #include <dpa/types/regular_fields.hpp>
 #include <dpa/types/relative_direction.hpp>
+#include <dpa/utility/numa_arenas.hpp>
 
 namespace dpa
 {
+// Loads either from a single (shared) HDF5 file through MPI-IO, or from a directory / manifest of pre-split block files
+// (see source/tools/block_splitter.cpp) in which case each rank independently opens only the files overlapping its blocks.
 class regular_grid_loader
 {
 public:
-  explicit regular_grid_loader  (domain_partitioner* partitioner, const std::string& filepath, const std::string& dataset_path, const std::string& spacing_path);
+  struct block_manifest
+  {
+    struct block
+    {
+      std::string filepath;
+      svector3    offset  ;
+      svector3    size    ;
+    };
+
+    std::string        format         ; // "hdf5" or "raw" (native floats in XYZV order).
+    std::string        axis_order     ; // The layout of the blocks, which overrides the one of the loader if specified.
+    std::string        component_order;
+    svector3           dimensions     ; // In the layout of the blocks, as are the offsets and sizes of the blocks.
+    vector3            spacing        ;
+    std::vector<block> blocks         ;
+  };
+
+  // The axis order names the dimensions of the dataset (e.g. "zyx" for a dataset stored as ZYXV), the component order
+  // names the components of its vectors. Both are normalized to x, y, z once after loading. The defaults match the
+  // layout which was previously assumed, i.e. XYZV with reversed components. If NUMA arenas are given, the pages of the
+  // vector fields are first touched in parallel by the nodes which later advect the particles within them.
+  explicit regular_grid_loader  (domain_partitioner* partitioner, const std::string& filepath, const std::string& dataset_path, const std::string& spacing_path, const std::string& axis_order = "xyz", const std::string& component_order = "zyx", const std::optional<std::string>& cache_directory = std::nullopt, numa_arenas* arenas = nullptr, const bool huge_pages = false);
   regular_grid_loader           (const regular_grid_loader&  that) = delete ;
   regular_grid_loader           (      regular_grid_loader&& temp) = default;
  ~regular_grid_loader           ()                                 = default;
@@ -26,14 +55,58 @@ public:
   svector3                                                        load_dimensions   ();
   std::unordered_map<relative_direction, regular_vector_field_3d> load_vector_fields(const bool load_neighbors);
 
+  // Time-variant datasets are 5D, consisting of time slices (the first dimension) of the 4D layout of steady ones. Each
+  // slice is loaded as the vector fields of load_vector_fields, on a background thread which reads through the default
+  // (sec2) driver of HDF5 instead of MPI-IO, such that the slices of all ranks are read independently while advecting.
+  // One slice is pending at a time. Neither the block cache nor manifests apply to time-variant datasets.
+  std::size_t                                                     load_time_slice_count();
+  void                                                            prefetch_time_slice  (const std::size_t time_index, const bool load_neighbors);
+  // Blocks until the pending slice is loaded.
+  std::unordered_map<relative_direction, regular_vector_field_3d> wait_time_slice      ();
+
+  // True if the blocks of all ranks were mapped from the cache during the last load_vector_fields (i.e. a warm start).
+  bool                                                            cached            () const;
+
 protected:
-  regular_vector_field_3d                                         load_vector_field (const svector3& offset, const svector3& size, hid_t dataset, hid_t spacing);
+  // The block cache stores each (ghosted) block as a header followed by the raw elements starting at a page boundary.
+  struct block_cache_header
+  {
+    std::array<char, 8>          magic        {};
+    std::uint64_t                version      {};
+    std::uint64_t                element_size {};
+    std::int64_t                 source_time  {}; // Last write time of the input dataset, invalidates stale entries.
+    std::array<std::uint64_t, 3> shape        {};
+    std::array<scalar, 3>        offset       {};
+    std::array<scalar, 3>        size         {};
+    std::array<scalar, 3>        spacing      {};
+    std::uint64_t                data_offset  {};
+  };
+
+  // Reads the time slice of a time-variant dataset if a time index is given.
+  void                                                            load_vector_field (std::unordered_map<relative_direction, regular_vector_field_3d>& vector_fields, relative_direction direction, const svector3& offset, const svector3& size, hid_t dataset, hid_t spacing, const std::optional<std::size_t>& time_index = std::nullopt);
+  void                                                            load_blocks       (vector3* data, const svector3& offset, const svector3& size) const;
+  // Transposes the data from the layout of the dataset into the vector field in parallel, or permutes its components in place if the data is null.
+  void                                                            normalize         (regular_vector_field_3d& vector_field, const regular_vector_field_3d::array_type* data) const;
+
+  std::string                                                     cache_filepath    (const svector3& offset, const svector3& size) const;
+  std::optional<block_cache_header>                               load_cache_header (const svector3& offset, const svector3& size) const;
+  bool                                                            load_cached_vector_field(std::unordered_map<relative_direction, regular_vector_field_3d>& vector_fields, relative_direction direction, const svector3& offset, const svector3& size) const;
+  void                                                            save_cached_vector_field(const regular_vector_field_3d& vector_field, const svector3& offset, const svector3& size) const;
+
+  domain_partitioner*           partitioner_     = nullptr;
+  numa_arenas*                  arenas_          = nullptr;
+  const std::string             filepath_        ;
+  const std::string             dataset_path_    ;
+  const std::string             spacing_path_    ;
+  std::optional<std::string>    cache_directory_ ;
+  std::optional<block_manifest> manifest_        ;
+  std::array<std::size_t, 3>    axis_order_      {0, 1, 2}; // The axis      of x, y, z of each dimension of the dataset.
+  std::array<std::size_t, 3>    component_order_ {2, 1, 0}; // The component of x, y, z of each component of the dataset.
+  bool                          huge_pages_      = false;
+  bool                          cached_          = false;
 
-  domain_partitioner* partitioner_ = nullptr;
-  const std::string   filepath_    ;
-  const std::string   dataset_path_;
-  const std::string   spacing_path_;
+  std::future<std::unordered_map<relative_direction, regular_vector_field_3d>> pending_time_slice_ = {};
 };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -18,11 +18,16 @@ public:
   regular_grid_saver& operator=(const regular_grid_saver&  that) = delete ;
   regular_grid_saver& operator=(      regular_grid_saver&& temp) = default;
 
-  void save(const regular_scalar_field_3d& scalar_field);
+  void save       (const regular_scalar_field_3d& scalar_field);
+  // Collective alternative to save for fields sampled at a stride of the (ghosted) vector field blocks, such as the FTLE
+  // field: all ranks write the strided cells of their (non-ghosted) block as a hyperslab of one global dataset, which is
+  // chunked by blocks, in a single file described by a single XDMF file.
+  void save_shared(const regular_scalar_field_3d& scalar_field, const vector3& stride);
   
 protected:
-  domain_partitioner* partitioner_ = {};
-  std::string         filepath_    = {};
+  domain_partitioner* partitioner_     = {};
+  std::string         filepath_        = {};
+  std::string         shared_filepath_ = {};
 };
 }
 
@@ -3,6 +3,7 @@
 
 #include <optional>
 #include <string>
+#include <vector>
 
 #include <dpa/types/basic_types.hpp>
 
@@ -10,23 +11,48 @@ namespace dpa
 {
 struct arguments
 {
-  std::string             input_dataset_filepath               ;
-  std::string             input_dataset_name                   ;
-  std::string             input_dataset_spacing_name           ;
-  std::optional<vector3>  seed_generation_stride               ; // Existence implies deterministic seed generation.
-  std::optional<size>     seed_generation_count                ; // Existence implies random seed generation.
-  std::optional<svector2> seed_generation_range                ; // Existence implies random seed count and generation.
-  size                    seed_generation_iterations           ;
-  std::optional<aabb3>    seed_generation_boundaries           ;
-  size                    particle_advector_particles_per_round;
-  std::string             particle_advector_load_balancer      ;
-  std::string             particle_advector_integrator         ;
-  scalar                  particle_advector_step_size          ;
-  bool                    particle_advector_gather_particles   ;
-  bool                    particle_advector_record             ;
-  bool                    estimate_ftle                        ;
-  std::string             output_dataset_filepath              ;
+  std::optional<size>        thread_count                           ; // Existence limits the number of threads per process.
+  bool                       numa_pinning                           ; // Loads and advects within one pinned arena per NUMA node.
+  bool                       huge_pages                             ; // Backs vector fields and integral curves with huge pages.
+  std::string                input_dataset_filepath                 ;
+  std::string                input_dataset_name                     ;
+  std::string                input_dataset_spacing_name             ;
+  std::string                input_dataset_axis_order               ; // E.g. "zyx" for a dataset stored as ZYXV.
+  std::string                input_dataset_component_order          ; // E.g. "zyx" for vectors stored as ZYX.
+  std::optional<std::string> input_dataset_cache_directory          ; // Existence implies block caching.
+  bool                       input_dataset_cache_preprocess         ; // Exits after the blocks are cached.
+  scalar                     input_dataset_time_spacing             ; // The time between the slices of a 5D (TXYZV) dataset.
+  std::optional<vector3>     seed_generation_stride                 ; // Existence implies deterministic seed generation.
+  std::optional<size>        seed_generation_count                  ; // Existence implies random seed generation.
+  std::optional<svector2>    seed_generation_range                  ; // Existence implies random seed count and generation.
+  size                       seed_generation_iterations             ;
+  std::optional<aabb3>       seed_generation_boundaries             ;
+  size                       particle_advector_particles_per_round  ;
+  std::string                particle_advector_load_balancer        ;
+  std::string                particle_advector_integrator           ;
+  scalar                     particle_advector_step_size            ;
+  bool                       particle_advector_gather_particles     ;
+  bool                       particle_advector_record               ;
+  bool                       particle_advector_generate_indices     ; // Replaces the index_generator.
+  std::string                particle_advector_attribute            ; // "none", "angular_velocity" or "velocity". Replaces the color_generator.
+  std::string                particle_advector_recording            ; // "all", "every_nth", "arc_length" or "simplified".
+  scalar                     particle_advector_recording_parameter  ; // N, the arc length or epsilon respectively.
+  bool                       particle_advector_quantize             ; // Holds the curves as 3x16-bit vertices within their bounds (lossy).
+  bool                       particle_advector_integrate_deformation; // Integrates the deformation gradient of each particle, yielding its FTLE without neighbors.
+  std::string                particle_advector_interpolation        ; // "linear" or "cubic" (Catmull-Rom, with a ghost width of 3).
+  bool                       integral_curve_stitching               ; // Concatenates the segments of each particle on one rank before saving, precludes streaming.
+  bool                       integral_curve_saver_streaming         ; // Saves each round in the background during the next.
+  bool                       integral_curve_saver_shared            ; // Saves into a single file collectively, unless streaming.
+  std::string                integral_curve_saver_compression       ; // "none", "deflate" or "lz4".
+  std::optional<size>        integral_curve_saver_mantissa_bits     ; // Existence implies lossy rounding of vertices.
+  bool                       integral_curve_saver_spatial_index     ; // Sorts the polylines in morton order and indexes their chunks, unless streaming or shared.
+  bool                       estimate_ftle                          ;
+  std::vector<size>          ftle_estimator_horizons                ; // Iteration counts of additional FTLE fields, snapshot during advection.
+  std::optional<size>        ftle_estimator_compositions            ; // Existence implies FTLE fields of 2 to N times the integration time from composed flow maps.
+  bool                       ftle_estimator_distributed             ; // Sends final positions to their original ranks and exchanges a flow map halo, instead of requiring gathered particles.
+  bool                       regular_grid_saver_shared              ; // Saves the FTLE field into a single global dataset collectively.
+  std::string                output_dataset_filepath                ;
 };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -1,21 +1,108 @@
 #ifndef DPA_TYPES_INTEGRAL_CURVES_HPP
 #define DPA_TYPES_INTEGRAL_CURVES_HPP
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
 #include <variant>
 #include <vector>
 
+#include <tbb/tbb.h>
+
 #include <dpa/types/basic_types.hpp>
+#include <dpa/utility/allocator.hpp>
 
 namespace dpa
 {
 struct integral_curve
 {
-  std::vector<vector3>                                                 vertices;
-  std::variant<std::vector<scalar>       , std::vector<bvector3>>      colors  ;
-  std::variant<std::vector<std::uint32_t>, std::vector<std::uint64_t>> indices ;
+  using vertex_vector           = std::vector<vector3, allocator<vector3>>;
+  using quantized_vertex        = std::array<std::uint16_t, 3>;
+  using quantized_vertex_vector = std::vector<quantized_vertex>;
+
+  // Quantized vertices are stored as 16 bits per component within the bounds of the curve. Each component is off by at
+  // most half a quantization step, i.e. the extent of the bounds along it / (2 * quantization_steps), plus the rounding
+  // of the decoding in single precision. Terminal vertices are preserved exactly as the maximum value.
+  static constexpr std::uint16_t quantized_terminal = std::numeric_limits<std::uint16_t>::max();
+  static constexpr scalar        quantization_steps = scalar(quantized_terminal - 1);
+
+  bool                 quantized       () const
+  {
+    return !quantized_vertices.empty();
+  }
+  std::size_t          vertex_count    () const
+  {
+    return quantized() ? quantized_vertices.size() : vertices.size();
+  }
+
+  // Replaces the vertices by their quantized counterparts.
+  void                 quantize        ()
+  {
+    if (vertices.empty()) return;
+
+    using bounds_type = std::pair<vector3, vector3>;
+    const auto bounds = tbb::parallel_reduce(tbb::blocked_range<std::size_t>(0, vertices.size()),
+      bounds_type(vector3::Constant(std::numeric_limits<scalar>::max()), vector3::Constant(std::numeric_limits<scalar>::lowest())),
+      [&] (const tbb::blocked_range<std::size_t>& range, bounds_type bounds)
+      {
+        for (auto i = range.begin(); i < range.end(); ++i)
+          if (vertices[i] != terminal_value<vector3>())
+            bounds = {bounds.first.cwiseMin(vertices[i]), bounds.second.cwiseMax(vertices[i])};
+        return bounds;
+      },
+      [ ] (const bounds_type& lhs, const bounds_type& rhs)
+      {
+        return bounds_type(lhs.first.cwiseMin(rhs.first), lhs.second.cwiseMax(rhs.second));
+      });
+
+    quantization_origin = bounds.first;
+    quantization_step   = ((bounds.second - bounds.first) / quantization_steps).cwiseMax(vector3::Zero());
+    quantized_vertices  = quantized_vertex_vector(vertices.size());
+    tbb::parallel_for(std::size_t(0), vertices.size(), std::size_t(1), [&] (const std::size_t i)
+    {
+      const auto terminal = vertices[i] == terminal_value<vector3>();
+      for (auto j = 0; j < 3; ++j)
+        quantized_vertices[i][j] =
+          terminal                         ? quantized_terminal :
+          quantization_step[j] > scalar(0) ? static_cast<std::uint16_t>(std::clamp(std::round((vertices[i][j] - quantization_origin[j]) / quantization_step[j]), scalar(0), quantization_steps)) :
+                                             std::uint16_t(0);
+    });
+    vertex_vector(vertices.get_allocator()).swap(vertices);
+  }
+  // The vertices, decoded into the buffer if quantized.
+  const vertex_vector& decoded_vertices(vertex_vector& buffer) const
+  {
+    if (!quantized()) return vertices;
+
+    buffer.resize(quantized_vertices.size());
+    tbb::parallel_for(std::size_t(0), quantized_vertices.size(), std::size_t(1), [&] (const std::size_t i)
+    {
+      const auto& vertex = quantized_vertices[i];
+      buffer[i] = vertex[0] == quantized_terminal
+        ? terminal_value<vector3>()
+        : vector3(quantization_origin + vector3(vertex[0], vertex[1], vertex[2]).cwiseProduct(quantization_step));
+    });
+    return buffer;
+  }
+
+  vertex_vector                                                        vertices           ;
+  std::variant<std::vector<scalar>       , std::vector<bvector3>>      colors             ;
+  std::variant<std::vector<std::uint32_t>, std::vector<std::uint64_t>> indices            ;
+  quantized_vertex_vector                                              quantized_vertices {};
+  vector3                                                              quantization_origin{};
+  vector3                                                              quantization_step  {};
+
+  // One polyline per particle (and round) of the vertices. The offsets are the exclusive prefix sum of their vertex
+  // counts including the terminal vertices (hence contain one more element). See curve_stitcher.
+  std::vector<std::uint64_t>                                           polyline_ids       {};
+  std::vector<std::uint32_t>                                           polyline_segments  {};
+  std::vector<std::size_t>                                             polyline_offsets   {};
 };
 
 using integral_curves = std::vector<integral_curve>;
 }
 
-#endif
\ No newline at end of file
+#endif
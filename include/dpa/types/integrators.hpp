@@ -45,6 +45,11 @@ using variant_vector4_integrator              = variant_integrator<vector4>;
 using variant_matrix2_integrator              = variant_integrator<matrix2>;
 using variant_matrix3_integrator              = variant_integrator<matrix3>;
 using variant_matrix4_integrator              = variant_integrator<matrix4>;
+
+// Matrices integrated as flattened (column-major) vectors, since odeint copies the states of some steppers (e.g. the
+// modified midpoint and Adams-Bashforth ones) through the STL iterators of Eigen, which only vectors provide.
+using flattened_matrix3                       = Eigen::Matrix<scalar, 1, 9>;
+using variant_flattened_matrix3_integrator    = variant_integrator<flattened_matrix3>;
 }
 
 #endif
\ No newline at end of file
@@ -12,6 +12,9 @@ namespace dpa
 template <typename position_type, typename size_type>
 struct particle
 {
+  using scalar_type      = typename position_type::Scalar;
+  using deformation_type = Eigen::Matrix<typename position_type::Scalar, position_type::SizeAtCompileTime, position_type::SizeAtCompileTime>;
+
   particle() = default;
   particle(
     const position_type&     position            , 
@@ -53,6 +56,9 @@ struct particle
     archive & position[2];
     archive & remaining_iterations;
     archive & relative_direction;
+    archive & id;
+    archive & segment;
+    archive & step_remainder;
 
 #ifdef DPA_FTLE_SUPPORT
     archive & original_rank;
@@ -60,15 +66,27 @@ struct particle
     archive & original_position[1];
     archive & original_position[2];
 #endif
+
+#ifdef DPA_DEFORMATION_SUPPORT
+    for (auto i = 0; i < deformation.size(); ++i)
+      archive & deformation.data()[i];
+#endif
   }
 
-  position_type           position             = {};
-  size_type               remaining_iterations = 0 ;
-  dpa::relative_direction relative_direction   = center;
+  position_type              position             = {};
+  size_type                  remaining_iterations = 0 ;
+  dpa::relative_direction    relative_direction   = center;
+  std::uint64_t              id                   = 0 ; // Globally unique, identifies the curve of the particle.
+  std::uint32_t              segment              = 0 ; // Number of curve segments recorded so far, one per round advected.
+  scalar_type                step_remainder       = 0 ; // Of a step interrupted at the bounds of a block (see particle_advector), zero otherwise.
 
 #ifdef DPA_FTLE_SUPPORT
-  integer                 original_rank        = 0 ;
-  position_type           original_position    = {};
+  integer                    original_rank        = 0 ;
+  position_type              original_position    = {};
+#endif
+
+#ifdef DPA_DEFORMATION_SUPPORT
+  deformation_type           deformation          = deformation_type::Identity(); // Gradient of the flow map at the particle, if integrated.
 #endif
 };
 
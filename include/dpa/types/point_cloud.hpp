@@ -0,0 +1,18 @@
+#ifndef DPA_TYPES_POINT_CLOUD_HPP
+#define DPA_TYPES_POINT_CLOUD_HPP
+
+#include <vector>
+
+#include <dpa/types/basic_types.hpp>
+
+namespace dpa
+{
+// Scalar values at scattered positions, e.g. one per particle.
+struct point_cloud
+{
+  std::vector<vector3> positions {};
+  std::vector<scalar>  values    {};
+};
+}
+
+#endif
\ No newline at end of file
@@ -2,15 +2,22 @@
 #define DPA_TYPES_REGULAR_GRID_HPP
 
 #include <array>
+#include <cassert>
 #include <cmath>
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <type_traits>
 #include <vector>
 
 #include <boost/multi_array.hpp>
+#include <tbb/tbb.h>
 
 #include <dpa/math/permute_for.hpp>
 #include <dpa/types/basic_types.hpp>
+#include <dpa/utility/allocator.hpp>
 
 namespace dpa
 {
@@ -20,9 +27,52 @@ struct regular_grid
 {
   static constexpr std::size_t dimensions = _dimensions;
 
-  using element_type = _element_type;
-  using domain_type  = typename vector_traits<scalar, dimensions>::type;
-  using index_type   = std::array<std::size_t, dimensions>;
+  using element_type   = _element_type;
+  using domain_type    = typename vector_traits<scalar, dimensions>::type;
+  using index_type     = std::array<std::size_t, dimensions>;
+  using allocator_type = allocator<element_type>;
+  using array_type     = boost::multi_array<element_type, dimensions, allocator_type>;
+  using potential_type = regular_grid<typename potential_traits<element_type, dimensions>::type, dimensions>;
+  // Maps the dimension, the potentials at the start of the lines along it and their increments up to the handover
+  // elements to the potentials at the start of the lines.
+  using line_offset_function = std::function<std::vector<typename potential_traits<element_type, dimensions>::type>(
+    std::size_t                                                                  ,
+    const std::vector<typename potential_traits<element_type, dimensions>::type>&,
+    const std::vector<typename potential_traits<element_type, dimensions>::type>&)>;
+
+  regular_grid           () = default;
+  // Constructs the data in place, as boost::multi_array is copied rather than moved (e.g. on emplacement into a map).
+  explicit regular_grid  (
+    const index_type&     shape                      , 
+    const domain_type&    offset    = domain_type()  , 
+    const domain_type&    size      = domain_type()  , 
+    const domain_type&    spacing   = domain_type()  , 
+    const allocator_type& allocator = allocator_type())
+  : data(shape, allocator), offset(offset), size(size), spacing(spacing)
+  {
+
+  }
+  // Copies do not share the potential cache, as either may be modified independently.
+  regular_grid           (const regular_grid&  that)
+  : data(that.data), offset(that.offset), size(that.size), spacing(that.spacing)
+  {
+
+  }
+  regular_grid           (      regular_grid&& temp) = default;
+ ~regular_grid           ()                          = default;
+  regular_grid& operator=(const regular_grid&  that)
+  {
+    if (this != &that)
+    {
+      data    = that.data   ;
+      offset  = that.offset ;
+      size    = that.size   ;
+      spacing = that.spacing;
+      potential_cache.reset();
+    }
+    return *this;
+  }
+  regular_grid& operator=(      regular_grid&& temp) = default;
 
   // Ducks [] on the domain_type.
   index_type    cell_index (const domain_type& position) const
@@ -64,18 +114,114 @@ struct regular_grid
       increment  [i] = 1;
     }
 
-    std::vector<element_type> intermediates;
-    intermediates.reserve(std::pow(2, dimensions));
-    permute_for<index_type>([&] (const index_type& index) { intermediates.push_back(data(index)); }, start_index, end_index, increment);
+    std::array<element_type, std::size_t(1) << dimensions> intermediates;
+    std::size_t                                             corner = 0;
+    permute_for<index_type>([&] (const index_type& index) { intermediates[corner++] = data(index); }, start_index, end_index, increment);
 
     for (std::int64_t i = dimensions - 1; i >= 0; --i)
-      for (std::size_t j = 0; j < std::pow(2, i); ++j)
+      for (std::size_t j = 0; j < (std::size_t(1) << i); ++j)
         intermediates[j] = (scalar(1) - weights[i]) * intermediates[2 * j] + weights[i] * intermediates[2 * j + 1];
     return intermediates[0];
   }
+  // Ducks [] on the domain_type. The analytic gradient of interpolate (column i being the derivative along dimension i),
+  // i.e. the Jacobian for vector elements, which is constant along each dimension within a cell.
+  typename gradient_traits<element_type, dimensions>::type interpolate_gradient(const domain_type& position) const
+  {
+    domain_type weights    ;
+    index_type  start_index;
+
+    for (std::size_t i = 0; i < dimensions; ++i)
+    {
+      weights    [i] = std::fmod ((position[i] - offset[i]) , spacing[i]) / spacing[i];
+      start_index[i] = std::floor((position[i] - offset[i]) / spacing[i]);
+    }
+
+    // Each corner contributes its element weighted by the product of the weights along the other dimensions, and by
+    // -1 / spacing (lower corner) or 1 / spacing (upper corner) along the dimension of the derivative.
+    typename gradient_traits<element_type, dimensions>::type gradient;
+    gradient.setZero();
+    for (std::size_t corner = 0; corner < (std::size_t(1) << dimensions); ++corner)
+    {
+      auto index = start_index;
+      for (std::size_t i = 0; i < dimensions; ++i)
+        index[i] += (corner >> i) & 1;
+      const auto& element = data(index);
+
+      for (std::size_t dimension = 0; dimension < dimensions; ++dimension)
+      {
+        auto factor = ((corner >> dimension) & 1 ? scalar(1) : scalar(-1)) / spacing[dimension];
+        for (std::size_t i = 0; i < dimensions; ++i)
+          if (i != dimension)
+            factor *= (corner >> i) & 1 ? weights[i] : scalar(1) - weights[i];
+        gradient.col(dimension) += factor * element.transpose();
+      }
+    }
+    return gradient;
+  }
+
+  // Ducks [] on the domain_type. Catmull-Rom (tricubic in 3D) interpolation of the 4^dimensions elements around the cell,
+  // which, unlike interpolate, is continuously differentiable across cells. Indices beyond the grid are clamped (i.e. at
+  // the domain boundary), hence blocks require a ghost width of one element more than for interpolate.
+  element_type  interpolate_cubic(const domain_type& position) const
+  {
+    std::array<std::array<scalar, 4>, dimensions> weights    ;
+    index_type                                    start_index;
+    cubic_stencil(position, start_index, weights, false);
+
+    auto result = zero_element();
+    for (std::size_t corner = 0; corner < (std::size_t(1) << (2 * dimensions)); ++corner)
+    {
+      auto index  = start_index;
+      auto weight = scalar(1);
+      for (std::size_t i = 0; i < dimensions; ++i)
+      {
+        const auto offset = (corner >> (2 * i)) & 3;
+        index[i] = clamped_index(i, start_index[i], offset);
+        weight  *= weights[i][offset];
+      }
+      result += weight * data(index);
+    }
+    return result;
+  }
+  // Ducks [] on the domain_type. The analytic gradient of interpolate_cubic (column i being the derivative along
+  // dimension i).
+  typename gradient_traits<element_type, dimensions>::type interpolate_cubic_gradient(const domain_type& position) const
+  {
+    std::array<std::array<scalar, 4>, dimensions> weights    ;
+    std::array<std::array<scalar, 4>, dimensions> derivatives;
+    index_type                                    start_index;
+    cubic_stencil(position, start_index, weights    , false);
+    cubic_stencil(position, start_index, derivatives, true );
+
+    typename gradient_traits<element_type, dimensions>::type gradient;
+    gradient.setZero();
+    for (std::size_t corner = 0; corner < (std::size_t(1) << (2 * dimensions)); ++corner)
+    {
+      auto index = start_index;
+      for (std::size_t i = 0; i < dimensions; ++i)
+        index[i] = clamped_index(i, start_index[i], (corner >> (2 * i)) & 3);
+      const auto& element = data(index);
+
+      for (std::size_t dimension = 0; dimension < dimensions; ++dimension)
+      {
+        auto factor = scalar(1);
+        for (std::size_t i = 0; i < dimensions; ++i)
+        {
+          const auto offset = (corner >> (2 * i)) & 3;
+          factor *= i == dimension ? derivatives[i][offset] / spacing[i] : weights[i][offset];
+        }
+        gradient.col(dimension) += factor * element.transpose();
+      }
+    }
+    return gradient;
+  }
 
-  void          apply      (std::function<void(const index_type&, element_type&)> function)
+  // Calls function(const index_type&, element_type&) for each element in parallel. Invalidates the potential.
+  template <typename function_type>
+  void          apply      (const function_type& function)
   {
+    potential_cache.reset();
+
     index_type start_index; start_index.fill(0);
     index_type end_index  ;
     index_type increment  ; increment  .fill(1);
@@ -91,7 +237,7 @@ struct regular_grid
     auto& shape       = reinterpret_cast<index_type const&>(*data.shape());
     auto  two_spacing = domain_type(2 * spacing);
 
-    gradient_type gradient {boost::multi_array<typename gradient_type::element_type, dimensions>(shape), offset, size, spacing};
+    gradient_type gradient (shape, offset, size, spacing);
     gradient.apply([&] (const index_type& index, typename gradient_type::element_type& element)
     {
       for (std::size_t dimension = 0; dimension < dimensions; ++dimension)
@@ -106,49 +252,152 @@ struct regular_grid
     });
     return gradient;
   }
-  regular_grid<typename potential_traits<element_type, dimensions>::type, dimensions> potential() const
+  // The line integral (by the trapezoidal rule) from the first element along dimension 0, then along 1 and so on, i.e. a
+  // potential if the field is conservative. The lines along each dimension start at the elements integrated along the
+  // previous ones, and are integrated by one parallel scan each. A block of a distributed grid passes the (local) indices
+  // at which the lines of the next blocks start, and a function which maps the potentials at the start of its lines
+  // along a dimension and their increments up to these to the potentials at the start of its lines (see
+  // color_generator). Computed on the first call and cached until the next apply or copy assignment, hence later calls
+  // must pass the same arguments, and direct writes to the data in between are not reflected.
+  const potential_type& potential(
+    const line_offset_function& line_offsets = nullptr     ,
+    const index_type&           handover     = index_type()) const
   {
-    using potential_type = regular_grid<typename potential_traits<element_type, dimensions>::type, dimensions>;
+    if (potential_cache)
+    {
+      assert(handover == potential_handover && static_cast<bool>(line_offsets) == potential_distributed);
+      return *potential_cache;
+    }
 
-    auto& shape       = reinterpret_cast<index_type const&>(*data.shape());
-    auto  two_spacing = domain_type(2 * spacing);
-    
-    index_type start_index; start_index.fill(0);
-    index_type end_index  ; end_index  .fill(1);
-    index_type increment  ; increment  .fill(1);
+    using potential_element = typename potential_traits<element_type, dimensions>::type;
 
-    potential_type potential {boost::multi_array<typename potential_type::element_type, dimensions>(shape), offset, size, spacing};
+    const auto  zero        = [ ] ()
+    {
+      if constexpr (std::is_arithmetic<potential_element>::value)
+        return potential_element(0);
+      else
+        return potential_element(potential_element::Zero());
+    };
+    const auto  integrand   = [&] (const index_type& index, const std::size_t dimension)
+    {
+      // TODO: Extend to 3rd+ order tensors via <unsupported/Eigen/CXX11/Tensor>.
+      if constexpr (std::is_arithmetic<potential_element>::value)
+        return potential_element(data(index).col(dimension).array().value());
+      else
+        return potential_element(data(index).col(dimension).array());
+    };
+
+    auto& shape     = reinterpret_cast<index_type const&>(*data.shape());
+    auto  potential = std::make_shared<potential_type>(shape, offset, size, spacing);
     for (std::size_t dimension = 0; dimension < dimensions; ++dimension)
     {
-      for (std::size_t serial_index = 1; serial_index < shape[dimension]; ++serial_index)
+      // The lines along the dimension span the previous dimensions, at the first element of the others.
+      std::size_t line_count = 1;
+      for (std::size_t i = 0; i < dimension; ++i)
+        line_count *= shape[i];
+      const auto line_start = [&] (std::size_t line)
       {
-        auto partial_start_index = start_index; partial_start_index[dimension] = serial_index    ;
-        auto partial_end_index   = end_index  ; partial_end_index  [dimension] = serial_index + 1;
+        index_type index; index.fill(0);
+        for (std::size_t i = 0; i < dimension; ++i)
+        {
+          index[i] = line % shape[i];
+          line    /= shape[i];
+        }
+        return index;
+      };
 
-        parallel_permute_for<index_type>([&] (const index_type& index)
+      const auto half_spacing = spacing[dimension] / scalar(2);
+      const auto end          = std::min(handover[dimension], shape[dimension] - 1);
+
+      // The integrals from the start of each line, with the start holding the potential of the previous dimensions.
+      std::vector<potential_element> bases     (line_count);
+      std::vector<potential_element> increments(line_count);
+      tbb::parallel_for(std::size_t(0), line_count, std::size_t(1), [&] (const std::size_t line)
+      {
+        auto index = line_start(line);
+        bases[line] = potential->data(index);
+        potential->data(index) = zero();
+
+        tbb::parallel_scan(tbb::blocked_range<std::size_t>(1, shape[dimension]), zero(), [&] (const tbb::blocked_range<std::size_t>& range, potential_element sum, const bool is_final)
         {
-          auto prev_index = index, next_index = index;
-          if (index[dimension] > 0)                    prev_index[dimension] -= 1;
-          if (index[dimension] < shape[dimension] - 1) next_index[dimension] += 1;
-
-          // TODO: Extend to 3rd+ order tensors via <unsupported/Eigen/CXX11/Tensor>.
-          if constexpr (std::is_arithmetic<typename potential_type::element_type>::value)
-            potential.data(index) = potential.data(prev_index) + two_spacing[dimension] * typename potential_type::element_type((data(prev_index).col(dimension).array() + data(index).col(dimension).array()).value());
-          else                                           
-            potential.data(index) = potential.data(prev_index) + two_spacing[dimension] * typename potential_type::element_type( data(prev_index).col(dimension).array() + data(index).col(dimension).array());
-        }, partial_start_index, partial_end_index, increment);
-      }
-      end_index[dimension] = shape[dimension];
+          auto local_index = index;
+          for (auto i = range.begin(); i != range.end(); ++i)
+          {
+            auto prev_index = local_index; prev_index[dimension] = i - 1;
+            local_index[dimension] = i;
+            sum += half_spacing * (integrand(prev_index, dimension) + integrand(local_index, dimension));
+            if (is_final)
+              potential->data(local_index) = sum;
+          }
+          return sum;
+        }, std::plus<potential_element>());
+
+        auto end_index = index; end_index[dimension] = end;
+        increments[line] = potential->data(end_index);
+      });
+
+      const auto starts = line_offsets ? line_offsets(dimension, bases, increments) : bases;
+      tbb::parallel_for(tbb::blocked_range2d<std::size_t>(0, line_count, 0, shape[dimension]), [&] (const tbb::blocked_range2d<std::size_t>& range)
+      {
+        for (auto line = range.rows().begin(); line != range.rows().end(); ++line)
+        {
+          auto index = line_start(line);
+          for (auto i = range.cols().begin(); i != range.cols().end(); ++i)
+          {
+            index[dimension] = i;
+            potential->data(index) += starts[line];
+          }
+        }
+      });
     }
-    return potential;
+    potential_cache       = potential;
+    potential_handover    = handover;
+    potential_distributed = static_cast<bool>(line_offsets);
+    return *potential_cache;
   }
 
   // TODO: Orient Eigenvectors, compute structure tensor.
 
-  boost::multi_array<element_type, dimensions> data    {};
-  domain_type                                  offset  {};
-  domain_type                                  size    {};
-  domain_type                                  spacing {};
+  array_type  data    {};
+  domain_type offset  {};
+  domain_type size    {};
+  domain_type spacing {};
+
+protected:
+  static element_type zero_element()
+  {
+    if constexpr (std::is_arithmetic<element_type>::value)
+      return element_type(0);
+    else
+      return element_type(element_type::Zero());
+  }
+  // The cell of the position (clamped to the grid) and the Catmull-Rom weights (or their derivatives with respect to the
+  // local coordinate) of the elements [cell - 1, cell + 2] along each dimension.
+  void                cubic_stencil(const domain_type& position, index_type& start_index, std::array<std::array<scalar, 4>, dimensions>& weights, const bool derivative) const
+  {
+    for (std::size_t i = 0; i < dimensions; ++i)
+    {
+      const auto coordinate = (position[i] - offset[i]) / spacing[i];
+      const auto last_cell  = static_cast<scalar>(data.shape()[i] > 1 ? data.shape()[i] - 2 : 0);
+      const auto cell       = std::clamp(std::floor(coordinate), scalar(0), last_cell);
+      const auto t          = std::clamp(coordinate - cell, scalar(0), scalar(1));
+      start_index[i] = static_cast<std::size_t>(cell);
+      if (derivative)
+        weights  [i] = {(-3 * t * t + 4 * t - 1) / 2, (9 * t * t - 10 * t) / 2, (-9 * t * t + 8 * t + 1) / 2, (3 * t * t - 2 * t) / 2};
+      else
+        weights  [i] = {((-t + 2) * t - 1) * t / 2, ((3 * t - 5) * t * t + 2) / 2, ((-3 * t + 4) * t + 1) * t / 2, (t - 1) * t * t / 2};
+    }
+  }
+  // The index of the element at offset [0, 4) of the stencil starting one before the cell, clamped to the grid.
+  std::size_t         clamped_index(const std::size_t dimension, const std::size_t cell, const std::size_t offset) const
+  {
+    const auto index = static_cast<std::int64_t>(cell + offset) - 1;
+    return static_cast<std::size_t>(std::clamp<std::int64_t>(index, 0, static_cast<std::int64_t>(data.shape()[dimension]) - 1));
+  }
+
+  mutable std::shared_ptr<const potential_type> potential_cache       {};
+  mutable index_type                            potential_handover    {}; // The arguments of the cached potential.
+  mutable bool                                  potential_distributed {};
 };
 }
 
@@ -0,0 +1,214 @@
+#ifndef DPA_UTILITY_ALLOCATOR_HPP
+#define DPA_UTILITY_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace dpa
+{
+// A region of a file (e.g. a block cache entry) which backs an allocation.
+struct file_region
+{
+  std::string filepath;
+  std::size_t offset  ; // Must be a multiple of the page size.
+};
+
+struct allocation_policy
+{
+  bool deferred_construction = false; // Default construction is skipped, the owner initializes (e.g. first touches) the elements.
+  bool huge_pages            = false; // Allocations of at least one huge page are backed by explicit (hugetlbfs) or transparent huge pages.
+};
+
+// The memory of the process backed by transparent and explicit huge pages in kilobytes, as reported by Linux.
+struct page_statistics
+{
+  std::size_t anonymous_huge_pages = 0;
+  std::size_t hugetlb_pages        = 0;
+};
+inline page_statistics load_page_statistics()
+{
+  page_statistics statistics;
+#ifdef __linux__
+  std::ifstream stream("/proc/self/smaps_rollup");
+  std::string   line;
+  while (std::getline(stream, line))
+  {
+    std::istringstream line_stream(line);
+    std::string        key  ;
+    std::size_t        value = 0;
+    line_stream >> key >> value;
+    if      (key == "AnonHugePages:")
+      statistics.anonymous_huge_pages += value;
+    else if (key == "Private_Hugetlb:" || key == "Shared_Hugetlb:")
+      statistics.hugetlb_pages        += value;
+  }
+#endif
+  return statistics;
+}
+
+// Allocates from the heap, or maps a file region copy-on-write if one is given. Mapped memory is not initialized on
+// construction so that its pages are faulted lazily, and is never written back to the file. Heap memory is neither if
+// the policy defers construction. Large heap allocations may be backed by huge pages to reduce TLB misses on random access.
+template <typename type>
+class allocator
+{
+public:
+  using value_type                             = type;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap            = std::true_type;
+
+  static constexpr std::size_t huge_page_size  = 2 * 1024 * 1024;
+
+  allocator           ()                       = default;
+  explicit allocator  (std::shared_ptr<const dpa::file_region> file_region) : file_region_(std::move(file_region))
+  {
+
+  }
+  explicit allocator  (const allocation_policy& policy) : policy_(policy)
+  {
+
+  }
+  template <typename other_type>
+  allocator           (const allocator<other_type>& that) : file_region_(that.file_region()), policy_(that.policy())
+  {
+
+  }
+  allocator           (const allocator&  that) = default;
+  allocator           (      allocator&& temp) = default;
+ ~allocator           ()                       = default;
+  allocator& operator=(const allocator&  that) = default;
+  allocator& operator=(      allocator&& temp) = default;
+
+  type* allocate  (const std::size_t count)
+  {
+#ifdef __unix__
+    if (!file_region_ && uses_huge_pages(count))
+      return allocate_huge_pages(count);
+#endif
+    if (!file_region_)
+      return static_cast<type*>(::operator new(count * sizeof(type)));
+    if (count == 0)
+      return nullptr;
+
+#ifdef __unix__
+    const auto descriptor = open(file_region_->filepath.c_str(), O_RDONLY);
+    if (descriptor == -1)
+      throw std::bad_alloc();
+    const auto pointer    = mmap(nullptr, count * sizeof(type), PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, static_cast<off_t>(file_region_->offset));
+    close(descriptor);
+    if (pointer == MAP_FAILED)
+      throw std::bad_alloc();
+    return static_cast<type*>(pointer);
+#else
+    const auto pointer = static_cast<type*>(::operator new(count * sizeof(type)));
+    std::ifstream stream(file_region_->filepath, std::ios::binary);
+    stream.seekg(file_region_->offset);
+    stream.read (reinterpret_cast<char*>(pointer), count * sizeof(type));
+    return pointer;
+#endif
+  }
+  void  deallocate(type* pointer, const std::size_t count)
+  {
+#ifdef __unix__
+    if (file_region_)
+    {
+      if (pointer)
+        munmap(pointer, count * sizeof(type));
+      return;
+    }
+    if (uses_huge_pages(count))
+    {
+      munmap(pointer, huge_page_bytes(count));
+      return;
+    }
+#endif
+    ::operator delete(pointer);
+  }
+
+  template <typename other_type, typename... argument_types>
+  void  construct (other_type* pointer, argument_types&&... arguments)
+  {
+    // Default construction of mapped elements is skipped, their values are provided by the file.
+    if ((!file_region_ && !policy_.deferred_construction) || sizeof...(argument_types) > 0)
+      ::new (static_cast<void*>(pointer)) other_type(std::forward<argument_types>(arguments)...);
+  }
+
+  const std::shared_ptr<const dpa::file_region>& file_region() const
+  {
+    return file_region_;
+  }
+  const allocation_policy&                       policy     () const
+  {
+    return policy_;
+  }
+
+protected:
+  bool        uses_huge_pages    (const std::size_t count) const
+  {
+    return policy_.huge_pages && count * sizeof(type) >= huge_page_size;
+  }
+  std::size_t huge_page_bytes    (const std::size_t count) const
+  {
+    return ((count * sizeof(type) + huge_page_size - 1) / huge_page_size) * huge_page_size;
+  }
+#ifdef __unix__
+  // Anonymous mappings are zeroed and faulted lazily, hence remain compatible with deferred construction.
+  type*       allocate_huge_pages(const std::size_t count) const
+  {
+    const auto bytes = huge_page_bytes(count);
+#ifdef MAP_HUGETLB
+    // Explicit huge pages, requires pages to be reserved (e.g. through /proc/sys/vm/nr_hugepages).
+    const auto explicit_pointer = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (explicit_pointer != MAP_FAILED)
+      return static_cast<type*>(explicit_pointer);
+#endif
+
+    // Transparent huge pages, the mapping is over-allocated and trimmed to a huge page boundary.
+    const auto pointer = mmap(nullptr, bytes + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pointer == MAP_FAILED)
+      throw std::bad_alloc();
+
+    const auto address         = reinterpret_cast<std::uintptr_t>(pointer);
+    const auto aligned_address = ((address + huge_page_size - 1) / huge_page_size) * huge_page_size;
+    if (aligned_address > address)
+      munmap(pointer, aligned_address - address);
+    if (address + huge_page_size > aligned_address)
+      munmap(reinterpret_cast<void*>(aligned_address + bytes), address + huge_page_size - aligned_address);
+#ifdef MADV_HUGEPAGE
+    madvise(reinterpret_cast<void*>(aligned_address), bytes, MADV_HUGEPAGE);
+#endif
+    return reinterpret_cast<type*>(aligned_address);
+  }
+#endif
+
+  std::shared_ptr<const dpa::file_region> file_region_ {};
+  allocation_policy                       policy_      {};
+};
+
+template <typename lhs_type, typename rhs_type>
+bool operator==(const allocator<lhs_type>& lhs, const allocator<rhs_type>& rhs)
+{
+  return lhs.file_region() == rhs.file_region() && lhs.policy().deferred_construction == rhs.policy().deferred_construction && lhs.policy().huge_pages == rhs.policy().huge_pages;
+}
+template <typename lhs_type, typename rhs_type>
+bool operator!=(const allocator<lhs_type>& lhs, const allocator<rhs_type>& rhs)
+{
+  return !(lhs == rhs);
+}
+}
+
+#endif
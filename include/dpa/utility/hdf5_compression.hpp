@@ -0,0 +1,165 @@
+#ifndef DPA_UTILITY_HDF5_COMPRESSION_HPP
+#define DPA_UTILITY_HDF5_COMPRESSION_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <hdf5.h>
+#include <tbb/tbb.h>
+#include <zlib.h>
+
+namespace dpa
+{
+// Filters of chunked datasets. Deflate is applied after shuffle. LZ4 requires the HDF5 LZ4 filter plugin (registered
+// filter 32004) at runtime, and falls back to deflate if it is unavailable.
+enum class compression
+{
+  none   ,
+  deflate,
+  lz4
+};
+
+struct compression_statistics
+{
+  double ratio     () const
+  {
+    return compressed_bytes > 0 ? double(uncompressed_bytes) / double(compressed_bytes) : 1.0;
+  }
+  // In megabytes (of uncompressed data) per second.
+  double throughput() const
+  {
+    return seconds > 0 ? double(uncompressed_bytes) / (1024.0 * 1024.0) / seconds : 0.0;
+  }
+
+  std::size_t uncompressed_bytes = 0;
+  std::size_t compressed_bytes   = 0;
+  double      seconds            = 0;
+};
+
+constexpr H5Z_filter_t lz4_filter        = 32004;
+constexpr int          compression_level = 4;
+
+inline compression available_compression  (const compression compression)
+{
+  if (compression == compression::lz4 && H5Zfilter_avail(lz4_filter) <= 0)
+    return compression::deflate;
+  return compression;
+}
+inline void        set_compression_filters(const hid_t create_property, const compression compression)
+{
+  if      (compression == compression::deflate)
+  {
+    H5Pset_shuffle(create_property);
+    H5Pset_deflate(create_property, compression_level);
+  }
+  else if (compression == compression::lz4)
+    H5Pset_filter (create_property, lz4_filter, H5Z_FLAG_MANDATORY, 0, nullptr);
+}
+
+// Rounds floats to nearest with the given number of mantissa bits, zeroing the remaining bits such that they compress
+// well. Lossy, yet exactly representable values such as the invalid and terminal values are preserved.
+inline void        round_mantissa         (float* data, const std::size_t count, const std::size_t mantissa_bits)
+{
+  if (mantissa_bits >= 23)
+    return;
+
+  const auto dropped_bits = std::uint32_t(23 - mantissa_bits);
+  const auto mask         = ~((std::uint32_t(1) << dropped_bits) - 1);
+  const auto half         =   std::uint32_t(1) << (dropped_bits - 1);
+  tbb::parallel_for(tbb::blocked_range<std::size_t>(0, count), [&] (const tbb::blocked_range<std::size_t>& range)
+  {
+    for (auto i = range.begin(); i < range.end(); ++i)
+    {
+      std::uint32_t bits;
+      std::memcpy(&bits, &data[i], sizeof(float));
+      if ((bits & 0x7F800000u) == 0x7F800000u) // Infinite or NaN.
+        continue;
+      bits = (bits + half) & mask;
+      std::memcpy(&data[i], &bits, sizeof(float));
+    }
+  });
+}
+
+// Shuffles and deflates a chunk identically to the HDF5 shuffle and deflate filters, such that it can be written directly.
+inline std::vector<std::uint8_t> shuffle_and_deflate(const std::uint8_t* data, const std::size_t size, const std::size_t element_size)
+{
+  const auto element_count = size / element_size;
+
+  std::vector<std::uint8_t> shuffled(size);
+  for (std::size_t i = 0; i < element_count; ++i)
+    for (std::size_t j = 0; j < element_size; ++j)
+      shuffled[j * element_count + i] = data[i * element_size + j];
+
+  auto compressed_size = compressBound(static_cast<uLong>(size));
+  std::vector<std::uint8_t> compressed(compressed_size);
+  compress2(compressed.data(), &compressed_size, shuffled.data(), static_cast<uLong>(size), compression_level);
+  compressed.resize(compressed_size);
+  return compressed;
+}
+
+// Writes a 1D dataset, chunked unless uncompressed. Deflated chunks are compressed in parallel on TBB worker threads and
+// written directly, bypassing the (serial) filter pipeline of HDF5 which is used otherwise. Not applicable with MPI-IO.
+inline void        write_compressed       (const hid_t file, const std::string& name, const hid_t type, const std::size_t element_size, const void* data, const hsize_t count, const compression compression, const hsize_t chunk_size, compression_statistics& statistics)
+{
+  const auto start    = tbb::tick_count::now();
+  const auto space    = H5Screate_simple(1, &count, nullptr);
+  const auto property = H5Pcreate       (H5P_DATASET_CREATE);
+  if (count > 0 && compression != compression::none)
+  {
+    const auto chunk = std::min(chunk_size, count);
+    H5Pset_chunk(property, 1, &chunk);
+    set_compression_filters(property, compression);
+  }
+  const auto dataset  = H5Dcreate2      (file, name.c_str(), type, space, H5P_DEFAULT, property, H5P_DEFAULT);
+
+  if (count > 0 && compression == compression::deflate)
+  {
+    const auto chunk       = std::min(chunk_size, count);
+    const auto chunk_count = (count + chunk - 1) / chunk;
+    const auto bytes       = static_cast<const std::uint8_t*>(data);
+    const auto batch_size  = hsize_t(4 * tbb::this_task_arena::max_concurrency());
+
+    // Batches bound the memory of the compressed chunks. Edge chunks are zero-padded to the full chunk size.
+    for (hsize_t batch_begin = 0; batch_begin < chunk_count; batch_begin += batch_size)
+    {
+      const auto batch_end = std::min(batch_begin + batch_size, chunk_count);
+      std::vector<std::vector<std::uint8_t>> compressed_chunks(batch_end - batch_begin);
+      tbb::parallel_for(batch_begin, batch_end, [&] (const hsize_t chunk_index)
+      {
+        const auto offset = chunk_index * chunk;
+        const auto length = std::min(chunk, count - offset);
+        if (length == chunk)
+          compressed_chunks[chunk_index - batch_begin] = shuffle_and_deflate(bytes + offset * element_size, chunk * element_size, element_size);
+        else
+        {
+          std::vector<std::uint8_t> padded(chunk * element_size, 0);
+          std::memcpy(padded.data(), bytes + offset * element_size, length * element_size);
+          compressed_chunks[chunk_index - batch_begin] = shuffle_and_deflate(padded.data(), padded.size(), element_size);
+        }
+      });
+      for (auto chunk_index = batch_begin; chunk_index < batch_end; ++chunk_index)
+      {
+        const hsize_t offset = chunk_index * chunk;
+        auto&         buffer = compressed_chunks[chunk_index - batch_begin];
+        H5Dwrite_chunk(dataset, H5P_DEFAULT, 0, &offset, buffer.size(), buffer.data());
+      }
+    }
+  }
+  else if (count > 0)
+    H5Dwrite(dataset, type, H5S_ALL, H5S_ALL, H5P_DEFAULT, data);
+
+  statistics.uncompressed_bytes += count * element_size;
+  statistics.compressed_bytes   += H5Dget_storage_size(dataset);
+  statistics.seconds            += (tbb::tick_count::now() - start).seconds();
+
+  H5Dclose(dataset );
+  H5Pclose(property);
+  H5Sclose(space   );
+}
+}
+
+#endif
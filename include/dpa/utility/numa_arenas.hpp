@@ -0,0 +1,90 @@
+#ifndef DPA_UTILITY_NUMA_ARENAS_HPP
+#define DPA_UTILITY_NUMA_ARENAS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <tbb/tbb.h>
+
+namespace dpa
+{
+// One task arena per NUMA node, each pinned to the cores of its node. Work is divided into contiguous slabs (one per
+// node) such that the pages first touched by the threads of a node are later accessed by the same node. Falls back to
+// a single unconstrained arena if pinning is disabled or the TBB installation does not support NUMA constraints.
+class numa_arenas
+{
+public:
+  explicit numa_arenas  (const bool pinned = true, const std::optional<std::size_t>& thread_count = std::nullopt)
+  {
+#if TBB_INTERFACE_VERSION >= 12000
+    const auto nodes = pinned ? tbb::info::numa_nodes() : std::vector<tbb::numa_node_id> {tbb::task_arena::automatic};
+    for (auto& node : nodes)
+      arenas_.emplace_back(tbb::task_arena::constraints(
+        node,
+        thread_count ? static_cast<int>(std::max<std::size_t>(*thread_count / nodes.size(), 1)) : tbb::task_arena::automatic));
+#else
+    arenas_.emplace_back(thread_count ? static_cast<int>(*thread_count) : tbb::task_arena::automatic);
+#endif
+  }
+  numa_arenas           (const numa_arenas&  that) = delete ;
+  numa_arenas           (      numa_arenas&& temp) = default;
+ ~numa_arenas           ()                         = default;
+  numa_arenas& operator=(const numa_arenas&  that) = delete ;
+  numa_arenas& operator=(      numa_arenas&& temp) = default;
+
+  std::size_t                         size () const
+  {
+    return arenas_.size();
+  }
+  // The node of an index along a dimension of the given extent.
+  std::size_t                         node (const std::size_t index, const std::size_t extent) const
+  {
+    return std::min(index * arenas_.size() / std::max<std::size_t>(extent, 1), arenas_.size() - 1);
+  }
+  // The [begin, end) slab of a node along a dimension of the given extent.
+  std::pair<std::size_t, std::size_t> slab (const std::size_t node, const std::size_t extent) const
+  {
+    return {node * extent / arenas_.size(), (node + 1) * extent / arenas_.size()};
+  }
+
+  // Runs the function(node) in the arena of each node concurrently, and waits for all of them.
+  template <typename function_type>
+  void                                execute    (const function_type& function)
+  {
+    std::vector<tbb::task_group> task_groups(arenas_.size());
+    for (std::size_t i = 0; i < arenas_.size(); ++i)
+      arenas_[i].execute([&, i] () { task_groups[i].run([&, i] () { function(i); }); });
+    for (std::size_t i = 0; i < arenas_.size(); ++i)
+      arenas_[i].execute([&, i] () { task_groups[i].wait(); });
+  }
+
+  // Zero-initializes the slabs of the outermost dimension of the grid in parallel within the arenas of their nodes, which
+  // places their pages on the nodes. The grid is expected to be allocated with deferred construction.
+  template <typename grid_type>
+  void                                first_touch(grid_type& grid)
+  {
+    using element_type = typename grid_type::element_type;
+
+    const auto extent     = grid.data.shape()[0];
+    const auto slab_size  = extent > 0 ? grid.data.num_elements() / extent : 0;
+    const auto data       = grid.data.data();
+    execute([&] (const std::size_t node)
+    {
+      const auto range = slab(node, extent);
+      tbb::parallel_for(tbb::blocked_range<std::size_t>(range.first * slab_size, range.second * slab_size), [&] (const tbb::blocked_range<std::size_t>& elements)
+      {
+        std::memset(static_cast<void*>(data + elements.begin()), 0, elements.size() * sizeof(element_type));
+      });
+    });
+  }
+
+protected:
+  std::vector<tbb::task_arena> arenas_;
+};
+}
+
+#endif
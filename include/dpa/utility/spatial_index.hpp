@@ -0,0 +1,60 @@
+#ifndef DPA_UTILITY_SPATIAL_INDEX_HPP
+#define DPA_UTILITY_SPATIAL_INDEX_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+#include <dpa/types/basic_types.hpp>
+
+namespace dpa
+{
+// A run of spatially sorted polylines, saved as one row of the "chunk_bounds_[N]" (minimum and maximum, 6 floats) and
+// "chunk_ranges_[N]" (vertex begin and end, index begin and end, 4 uint64s) datasets alongside each curve.
+struct spatial_chunk
+{
+  vector3       minimum      ;
+  vector3       maximum      ;
+  std::uint64_t vertex_begin ;
+  std::uint64_t vertex_end   ;
+  std::uint64_t index_begin  ;
+  std::uint64_t index_end    ;
+};
+
+// Polylines are appended to a chunk until it holds at least this many vertices.
+constexpr std::size_t spatial_chunk_vertices = 1 << 16;
+
+const std::string chunk_bounds_prefix = "chunk_bounds_";
+const std::string chunk_ranges_prefix = "chunk_ranges_";
+
+// Interleaves the lower 21 bits of each component, x being the least significant.
+inline std::uint64_t morton_code(const std::uint32_t x, const std::uint32_t y, const std::uint32_t z)
+{
+  const auto spread = [ ] (std::uint64_t value)
+  {
+    value &= 0x1FFFFF;
+    value  = (value | value << 32) & 0x001F00000000FFFF;
+    value  = (value | value << 16) & 0x001F0000FF0000FF;
+    value  = (value | value <<  8) & 0x100F00F00F00F00F;
+    value  = (value | value <<  4) & 0x10C30C30C30C30C3;
+    value  = (value | value <<  2) & 0x1249249249249249;
+    return value;
+  };
+  return spread(x) | spread(y) << 1 | spread(z) << 2;
+}
+// The morton code of a point within the bounds, quantized to 21 bits per component.
+inline std::uint64_t morton_code(const vector3& point, const vector3& minimum, const vector3& maximum)
+{
+  constexpr auto steps = scalar((1 << 21) - 1);
+
+  std::uint32_t components[3];
+  for (auto i = 0; i < 3; ++i)
+  {
+    const auto extent = maximum[i] - minimum[i];
+    components[i] = extent > scalar(0) ? static_cast<std::uint32_t>(std::clamp((point[i] - minimum[i]) / extent, scalar(0), scalar(1)) * steps) : 0;
+  }
+  return morton_code(components[0], components[1], components[2]);
+}
+}
+
+#endif
@@ -33,6 +33,45 @@ const std::string xdmf_body_geometry = R"(
 
     </Grid>
 )";
+// Refers to a range (hyperslab) of datasets shared by multiple grids, e.g. one per round. Indices are local to the range.
+const std::string xdmf_body_geometry_hyperslab = R"(
+    <Grid Name="$GRID_NAME">
+
+      <Topology TopologyType="Polyline" NodesPerElement="2" NumberOfElements="$POLYLINE_COUNT">
+        <DataItem ItemType="HyperSlab" Dimensions="$INDEX_ARRAY_SIZE" Type="HyperSlab">
+          <DataItem Dimensions="3 1" Format="XML">
+            $INDEX_ARRAY_OFFSET 1 $INDEX_ARRAY_SIZE
+          </DataItem>
+          <DataItem Dimensions="$INDEX_DATASET_SIZE" NumberType="UInt" Precision="$INDEX_PRECISION" Format="HDF">
+            $FILEPATH:/$INDICES_DATASET_NAME
+          </DataItem>
+        </DataItem>
+      </Topology>
+
+      <Geometry GeometryType="XYZ">
+        <DataItem ItemType="HyperSlab" Dimensions="$VERTEX_ARRAY_SIZE" Type="HyperSlab">
+          <DataItem Dimensions="3 1" Format="XML">
+            $VERTEX_ARRAY_OFFSET 1 $VERTEX_ARRAY_SIZE
+          </DataItem>
+          <DataItem Dimensions="$VERTEX_DATASET_SIZE" NumberType="Float" Precision="4" Format="HDF">
+            $FILEPATH:/$VERTICES_DATASET_NAME
+          </DataItem>
+        </DataItem>
+      </Geometry>
+
+      <Attribute Name="Colors" AttributeType="$COLOR_ATTRIBUTE_TYPE" Center="Node">
+        <DataItem ItemType="HyperSlab" Dimensions="$COLOR_ARRAY_SIZE" Type="HyperSlab">
+          <DataItem Dimensions="3 1" Format="XML">
+            $COLOR_ARRAY_OFFSET 1 $COLOR_ARRAY_SIZE
+          </DataItem>
+          <DataItem Dimensions="$COLOR_DATASET_SIZE" NumberType="$COLOR_ARRAY_TYPE" Precision="$COLOR_PRECISION" Format="HDF">
+            $FILEPATH:/$COLORS_DATASET_NAME
+          </DataItem>
+        </DataItem>
+      </Attribute>
+
+    </Grid>
+)";
 const std::string xdmf_body_volume = R"(
     <Grid Name="Grid" GridType="Uniform">
       <Topology TopologyType="3DCoRectMesh" NumberOfElements="$SIZE"/>
@@ -51,6 +90,21 @@ const std::string xdmf_body_volume = R"(
       </Attribute>
     </Grid>
 )";
+const std::string xdmf_body_points = R"(
+    <Grid Name="Points">
+      <Topology TopologyType="Polyvertex" NumberOfElements="$POINT_COUNT"/>
+      <Geometry GeometryType="XYZ">
+        <DataItem Dimensions="$POINT_COUNT 3" NumberType="Float" Precision="4" Format="HDF">
+          $FILEPATH:/$POSITIONS_DATASET_NAME
+        </DataItem>
+      </Geometry>
+      <Attribute Name="Values" AttributeType="Scalar" Center="Node">
+        <DataItem Dimensions="$POINT_COUNT" NumberType="Float" Precision="4" Format="HDF">
+          $FILEPATH:/$VALUES_DATASET_NAME
+        </DataItem>
+      </Attribute>
+    </Grid>
+)";
 const std::string xdmf_footer = R"(
   </Domain>
 </Xdmf>
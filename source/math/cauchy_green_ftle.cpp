@@ -0,0 +1,19 @@
+#include <dpa/math/cauchy_green_ftle.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <dpa/math/symmetric_eigenvalues.hpp>
+
+#undef min
+#undef max
+
+namespace dpa
+{
+void cauchy_green_ftle(const scalar* c00, const scalar* c01, const scalar* c02, const scalar* c11, const scalar* c12, const scalar* c22, const std::size_t count, const scalar inverse_time, scalar* output)
+{
+  for (std::size_t i = 0; i < count; ++i)
+    output[i] = scalar(0.5) * std::log(std::max(largest_symmetric_eigenvalue(c00[i], c01[i], c02[i], c11[i], c12[i], c22[i]), std::numeric_limits<scalar>::min())) * inverse_time;
+}
+}
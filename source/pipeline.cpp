@@ -1,10 +1,21 @@
 #include <dpa/pipeline.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+
+#include <boost/mpi/collectives.hpp>
 #include <boost/mpi/environment.hpp>
+#include <tbb/tbb.h>
 
 #include <dpa/benchmark/benchmark.hpp>
 #include <dpa/stages/argument_parser.hpp>
 #include <dpa/stages/color_generator.hpp>
+#include <dpa/stages/curve_stitcher.hpp>
 #include <dpa/stages/ftle_estimator.hpp>
 #include <dpa/stages/index_generator.hpp>
 #include <dpa/stages/regular_grid_loader.hpp>
@@ -12,7 +23,9 @@
 #include <dpa/stages/domain_partitioner.hpp>
 #include <dpa/stages/integral_curve_saver.hpp>
 #include <dpa/stages/particle_advector.hpp>
+#include <dpa/stages/point_cloud_saver.hpp>
 #include <dpa/stages/uniform_seed_generator.hpp>
+#include <dpa/utility/numa_arenas.hpp>
 
 #undef min
 #undef max
@@ -25,35 +38,109 @@ std::int32_t pipeline::run(std::int32_t argc, char** argv)
   std::cout << "Started pipeline on " << environment.processor_name() << "\n";
 
   auto arguments         = argument_parser::parse(argv[1]);
+  auto thread_control    = std::optional<tbb::global_control>();
+  if (arguments.thread_count)
+    thread_control.emplace(tbb::global_control::max_allowed_parallelism, *arguments.thread_count);
+
   auto benchmark_session = run_mpi<float, std::milli>([&] (session_recorder<float, std::milli>& recorder)
   {
+    const auto use_64_bit = arguments.particle_advector_particles_per_round * arguments.seed_generation_iterations > std::numeric_limits<std::uint32_t>::max();
+    const auto stitch     = arguments.particle_advector_record &&  arguments.integral_curve_stitching;
+    const auto index      = arguments.particle_advector_record && !arguments.particle_advector_generate_indices && !stitch; // Indices are neither generated during advection nor stitching.
+    const auto color      = arguments.particle_advector_record &&  arguments.particle_advector_attribute == "none"; // Colors are not generated during advection.
+
+    // The FTLE horizons within the integration time in ascending order, which the advector snapshots at the (descending)
+    // remaining iterations corresponding to them.
+    auto horizons = std::vector<size>();
+    if (arguments.estimate_ftle)
+      std::copy_if(arguments.ftle_estimator_horizons.begin(), arguments.ftle_estimator_horizons.end(), std::back_inserter(horizons), [&] (const size horizon)
+      {
+        return horizon > 0 && horizon <= arguments.seed_generation_iterations;
+      });
+    std::sort(horizons.begin(), horizons.end());
+    horizons.erase(std::unique(horizons.begin(), horizons.end()), horizons.end());
+    auto horizon_remaining_iterations = std::vector<size>(horizons.size());
+    std::transform(horizons.begin(), horizons.end(), horizon_remaining_iterations.begin(), [&] (const size horizon) { return arguments.seed_generation_iterations - horizon; });
+
     auto partitioner     = domain_partitioner ();
+    auto arenas          = std::optional<numa_arenas>();
+    if (arguments.numa_pinning)
+      arenas.emplace(true, arguments.thread_count);
     auto loader          = regular_grid_loader(
-      &partitioner                        , 
-      arguments.input_dataset_filepath    , 
-      arguments.input_dataset_name        , 
-      arguments.input_dataset_spacing_name);
+      &partitioner                           , 
+      arguments.input_dataset_filepath       , 
+      arguments.input_dataset_name           , 
+      arguments.input_dataset_spacing_name   ,
+      arguments.input_dataset_axis_order     ,
+      arguments.input_dataset_component_order,
+      arguments.input_dataset_cache_directory,
+      arenas ? &*arenas : nullptr            ,
+      arguments.huge_pages                   );
     auto advector        = particle_advector(
-      &partitioner                                   , 
-      arguments.particle_advector_particles_per_round,
-      arguments.particle_advector_load_balancer      , 
-      arguments.particle_advector_integrator         ,
-      arguments.particle_advector_step_size          ,
-      arguments.particle_advector_gather_particles   ,
-      arguments.particle_advector_record             );
-
-    auto vector_fields = std::unordered_map<relative_direction, regular_vector_field_3d>();
-    auto particles     = std::vector<particle_3d>();
-    auto ftle_field    = std::optional<regular_scalar_field_3d>();
+      &partitioner                                     ,
+      arguments.particle_advector_particles_per_round  ,
+      arguments.particle_advector_load_balancer        ,
+      arguments.particle_advector_integrator           ,
+      arguments.particle_advector_step_size            ,
+      arguments.particle_advector_gather_particles     ,
+      arguments.particle_advector_record               ,
+      arguments.huge_pages                             ,
+      arenas ? &*arenas : nullptr                      ,
+      arguments.particle_advector_generate_indices     ,
+      use_64_bit                                       ,
+      arguments.particle_advector_attribute            ,
+      arguments.particle_advector_recording            ,
+      arguments.particle_advector_recording_parameter  ,
+      arguments.particle_advector_quantize             ,
+      horizon_remaining_iterations                     ,
+      arguments.particle_advector_integrate_deformation,
+      arguments.particle_advector_interpolation        );
+
+    auto vector_fields      = std::unordered_map<relative_direction, regular_vector_field_3d>();
+    auto next_vector_fields = std::unordered_map<relative_direction, regular_vector_field_3d>();
+    auto particles          = std::vector<particle_3d>();
+    auto ftle_field         = std::optional<regular_scalar_field_3d>();
 
     std::cout << "domain_partitioning\n";
-    partitioner.set_domain_size(loader.load_dimensions(), svector3::Ones());
+    const auto cubic = arguments.particle_advector_interpolation == "cubic" && arguments.particle_advector_integrator != "cell_stepping";
+    partitioner.set_domain_size(loader.load_dimensions(), svector3::Constant(cubic ? 3 : 1));
 
-    std::cout << "data_loading\n";
-    vector_fields = loader.load_vector_fields(
+    // Time-variant (5D) datasets are advected through one interval of slices at a time, with the slice after the next
+    // prefetched in the background.
+    const auto time_slice_count = loader.load_time_slice_count();
+    if (time_slice_count > 1 && arguments.particle_advector_step_size <= 0)
+      throw std::invalid_argument("Time-variant datasets require a positive particle_advector_step_size, as the slices are advanced forward in time.");
+    if (time_slice_count > 1 && arguments.estimate_ftle && arguments.ftle_estimator_compositions)
+      throw std::invalid_argument("Time-variant datasets do not support ftle_estimator_compositions, as composing a flow map with itself assumes a steady field.");
+    const auto load_neighbors   = 
       arguments.particle_advector_load_balancer == "diffuse_constant"                       || 
       arguments.particle_advector_load_balancer == "diffuse_lesser_average"                 || 
-      arguments.particle_advector_load_balancer == "diffuse_greater_limited_lesser_average" );
+      arguments.particle_advector_load_balancer == "diffuse_greater_limited_lesser_average" ;
+
+    std::cout << "data_loading\n";
+    recorder.record("data_loading_time", [&] ()
+    {
+      if (time_slice_count > 1)
+      {
+        loader.prefetch_time_slice(0, load_neighbors); vector_fields      = loader.wait_time_slice();
+        loader.prefetch_time_slice(1, load_neighbors); next_vector_fields = loader.wait_time_slice();
+        if (time_slice_count > 2)
+          loader.prefetch_time_slice(2, load_neighbors);
+      }
+      else
+        vector_fields = loader.load_vector_fields(load_neighbors);
+    });
+    recorder.set("data_loading_cached", loader.cached()); // Distinguishes warm (cached) from cold startups.
+    recorder.set("numa_nodes"         , arenas ? arenas->size() : 0);
+    recorder.set("huge_pages"         , arguments.huge_pages);
+
+    auto page_statistics = load_page_statistics();
+    std::cout << "data_loading_page_statistics: " << page_statistics.anonymous_huge_pages << " kB transparent, " << page_statistics.hugetlb_pages << " kB explicit huge pages\n";
+    recorder.set("data_loading_anonymous_huge_pages_kb", page_statistics.anonymous_huge_pages);
+    recorder.set("data_loading_hugetlb_pages_kb"       , page_statistics.hugetlb_pages       );
+
+    if (arguments.input_dataset_cache_preprocess)
+      return;
 
     std::cout << "seed_generation\n";
     const auto offset        = vector_fields[center].spacing.array() * partitioner.partitions().at(center).offset.cast<scalar>().array();
@@ -87,12 +174,63 @@ std::int32_t pipeline::run(std::int32_t argc, char** argv)
         process_index,
         boundaries   );
 
+    // Global particle ids, which identify the curve of each particle across ranks.
+    const auto id_offset = boost::mpi::scan(*partitioner.cartesian_communicator(), particles.size(), std::plus<std::size_t>()) - particles.size();
+    tbb::parallel_for(std::size_t(0), particles.size(), std::size_t(1), [&] (const std::size_t index)
+    {
+      particles[index].id = id_offset + index;
+    });
+
     std::cout << "particle_advection\n";
     particle_advector::state       state       = {vector_fields, particles, partitioner.partitions()};
     particle_advector::round_state round_state = particle_advector::round_state(partitioner.partitions());
     particle_advector::output      output      = {};
     integer                        rounds      = 0;
     bool                           complete    = false;
+    std::size_t                    time_slice  = 0;
+    // HDF5 is not thread-safe, hence the saves do not overlap with the slice prefetches.
+    const bool                     stream      = arguments.particle_advector_record && arguments.integral_curve_saver_streaming && !arguments.integral_curve_stitching && time_slice_count == 1;
+    integral_curve_saver           curve_saver   (&partitioner, arguments.output_dataset_filepath, arguments.integral_curve_saver_compression, arguments.integral_curve_saver_mantissa_bits, arguments.integral_curve_saver_spatial_index);
+
+    // The interval [k, k + 1] of the slices in time, up to the end of which the particles advance before pausing.
+    const auto make_time_interval = [&] (const std::size_t k)
+    {
+      return particle_advector::time_interval
+      {
+        &next_vector_fields,
+        iterations,
+        static_cast<std::size_t>(std::ceil(static_cast<double>(k + 1) * arguments.input_dataset_time_spacing / arguments.particle_advector_step_size)),
+        scalar(k) * arguments.input_dataset_time_spacing,
+        arguments.input_dataset_time_spacing
+      };
+    };
+    // Once the particles of all ranks paused or terminated within the interval, either resumes them in the next (whose
+    // end slice is waited for, and the one after prefetched) and returns false, or terminates them and returns true.
+    const auto advance_time_interval = [&] ()
+    {
+      const auto paused = boost::mpi::all_reduce(*partitioner.cartesian_communicator(), state.paused_particles.size(), std::plus<std::size_t>());
+      if (paused == 0 || time_slice + 2 >= time_slice_count)
+      {
+        if (time_slice + 2 < time_slice_count)
+          loader.wait_time_slice(); // Drains the prefetch before the saves.
+        advector.resume_paused_particles(state, output, true);
+        return true;
+      }
+
+      ++time_slice;
+      recorder.record("time_slice." + std::to_string(time_slice + 1) + ".io_wait_time", [&] ()
+      {
+        vector_fields      = std::move(next_vector_fields);
+        next_vector_fields = loader.wait_time_slice();
+      });
+      if (time_slice + 2 < time_slice_count)
+        loader.prefetch_time_slice(time_slice + 2, load_neighbors);
+      state.interval = make_time_interval(time_slice);
+      advector.resume_paused_particles(state, output, false);
+      return false;
+    };
+    if (time_slice_count > 1)
+      state.interval = make_time_interval(0);
 
     partitioner.cartesian_communicator()->barrier();
     recorder.record("total_time", [&] ()
@@ -124,8 +262,32 @@ std::int32_t pipeline::run(std::int32_t argc, char** argv)
                        
             // partitioner.cartesian_communicator()->barrier();
             // std::cout <<"prune_integral_curves\n";
-                          advector.prune_integral_curves   (                    output);
+                          advector.prune_integral_curves   (       round_state, output);
           });
+          if (arguments.particle_advector_record)
+          {
+            // Peak curve memory of the round before (as allocated, and as it would have been with a stride of the longest curve) and
+            // after pruning, and the ratio of steps to recorded vertices.
+            recorder.set   ("round." + std::to_string(rounds) + ".curve_strided_bytes"   , round_state.strided_vertex_count             * sizeof(vector3));
+            recorder.set   ("round." + std::to_string(rounds) + ".curve_allocated_bytes" , round_state.vertex_count                     * sizeof(vector3));
+            recorder.set   ("round." + std::to_string(rounds) + ".curve_pruned_bytes"    , output.integral_curves.back().vertex_count() * (arguments.particle_advector_quantize ? sizeof(integral_curve::quantized_vertex) : sizeof(vector3)));
+            recorder.set   ("round." + std::to_string(rounds) + ".vertex_reduction_ratio", static_cast<float>(std::accumulate(round_state.step_counts.begin(), round_state.step_counts.end(), std::size_t(0))) / std::max<std::size_t>(output.integral_curves.back().vertex_count(), 1));
+          }
+          if (stream)
+          {
+            auto round_curves = integral_curves {std::move(output.integral_curves.back())};
+            output.integral_curves.pop_back();
+            recorder.record("round." + std::to_string(rounds) + ".generation_time"    , [&] ()
+            {
+              if (index) index_generator::generate                        (round_curves, use_64_bit);
+              if (color) color_generator::generate_from_angular_velocities(round_curves);
+            });
+            recorder.record("round." + std::to_string(rounds) + ".save_time"          , [&] ()
+            {
+              // The write of this round overlaps with the advection of the next, hence this is the wait for the previous one.
+              curve_saver    .save_async                       (std::move(round_curves));
+            });
+          }
           recorder.record("round." + std::to_string(rounds) + ".communication_time" , [&] ()
           {
             // partitioner.cartesian_communicator()->barrier();
@@ -143,32 +305,130 @@ std::int32_t pipeline::run(std::int32_t argc, char** argv)
             rounds++;
           });
         });
+
+        if (complete && time_slice_count > 1)
+          complete = advance_time_interval();
       }
     });
     partitioner.cartesian_communicator()->barrier();
 
+    page_statistics = load_page_statistics();
+    std::cout << "particle_advection_page_statistics: " << page_statistics.anonymous_huge_pages << " kB transparent, " << page_statistics.hugetlb_pages << " kB explicit huge pages\n";
+    recorder.set("particle_advection_anonymous_huge_pages_kb", page_statistics.anonymous_huge_pages);
+    recorder.set("particle_advection_hugetlb_pages_kb"       , page_statistics.hugetlb_pages       );
+
     std::cout << "gather_particles\n";
     advector.gather_particles(output);
 
+    std::cout << "stitch_integral_curves\n";
+    if (stitch)
+      recorder.record("stitch_integral_curves_time", [&] ()
+      {
+        output.integral_curves = curve_stitcher::stitch(output.integral_curves, *partitioner.cartesian_communicator(), use_64_bit);
+      });
+
     std::cout << "index_generation\n";
-    if (arguments.particle_advector_record)
-      index_generator::generate(output.integral_curves, arguments.particle_advector_particles_per_round * arguments.seed_generation_iterations > std::numeric_limits<std::uint32_t>::max());
+    if (index && !stream)
+      index_generator::generate(output.integral_curves, use_64_bit);
     
     std::cout << "color_generation\n";
-    if (arguments.particle_advector_record)
+    if (color && !stream)
       color_generator::generate_from_angular_velocities(output.integral_curves);
 
     std::cout << "save_integral_curves\n";
     if (arguments.particle_advector_record)
-      integral_curve_saver(&partitioner, arguments.output_dataset_filepath).save(output.integral_curves);
+      recorder.record("save_integral_curves_time", [&] ()
+      {
+        if      (stream)
+          curve_saver.finalize   ();
+        else if (arguments.integral_curve_saver_shared)
+          curve_saver.save_shared(output.integral_curves);
+        else
+          curve_saver.save       (output.integral_curves);
+      });
+    if (arguments.particle_advector_record && arguments.integral_curve_saver_compression != "none")
+    {
+      const auto statistics = curve_saver.statistics();
+      std::cout << "save_integral_curves compression ratio " << statistics.ratio() << " throughput " << statistics.throughput() << " MB/s\n";
+      recorder.set("save_integral_curves_compression_ratio", static_cast<float>(statistics.ratio     ()));
+      recorder.set("save_integral_curves_throughput"       , static_cast<float>(statistics.throughput()));
+    }
+
+    const auto estimate_ftle = [&] (const dpa::size iterations, const particle_advector::concurrent_particle_vector& particles)
+    {
+      if (arguments.ftle_estimator_distributed)
+        return ftle_estimator::estimate_distributed(&partitioner, vector_fields.at(center), iterations, arguments.seed_generation_stride.value(), arguments.particle_advector_step_size, particles);
+      return   ftle_estimator::estimate            (              vector_fields.at(center), iterations, arguments.seed_generation_stride.value(), arguments.particle_advector_step_size, particles);
+    };
+    const auto save_ftle     = [&] (const regular_scalar_field_3d& field, const std::string& filepath)
+    {
+      if (arguments.regular_grid_saver_shared)
+        regular_grid_saver(&partitioner, filepath).save_shared(field, arguments.seed_generation_stride.value());
+      else
+        regular_grid_saver(&partitioner, filepath).save       (field);
+    };
 
     std::cout << "estimate_ftle\n";
     if (arguments.estimate_ftle)
-      ftle_field = ftle_estimator::estimate(vector_fields.at(center), arguments.seed_generation_iterations, arguments.seed_generation_stride.value(), arguments.particle_advector_step_size, output.inactive_particles);
+      recorder.record("ftle_estimation_time", [&] ()
+      {
+        ftle_field = estimate_ftle(arguments.seed_generation_iterations, output.inactive_particles);
+      });
     
     std::cout << "save_ftle_field\n";
     if (arguments.estimate_ftle)
-      regular_grid_saver(&partitioner, arguments.output_dataset_filepath).save(ftle_field.value());
+      save_ftle(ftle_field.value(), arguments.output_dataset_filepath);
+
+    // One additional field per horizon, e.g. [OUTPUT].horizon_100.rank_0_grid.h5.
+    for (std::size_t horizon = 0; horizon < horizons.size(); ++horizon)
+    {
+      std::cout << "estimate_ftle horizon " << horizons[horizon] << "\n";
+      save_ftle(estimate_ftle(horizons[horizon], output.horizon_particles[horizon]), std::filesystem::path(arguments.output_dataset_filepath).replace_extension().string() + ".horizon_" + std::to_string(horizons[horizon]) + ".h5");
+    }
+
+    // FTLE fields of 2 to N times the integration time from the composed flow map, e.g. [OUTPUT].composed_200.rank_0_grid.h5.
+    if (arguments.estimate_ftle && arguments.ftle_estimator_compositions)
+      recorder.record("estimate_composed_ftle_time", [&] ()
+      {
+        const auto  iterations = arguments.seed_generation_iterations;
+        const auto& stride     = arguments.seed_generation_stride.value();
+        const auto  global_map = ftle_estimator::gather_flow_map(&partitioner, vector_fields.at(center), stride, output.inactive_particles);
+        const auto  block_map  = ftle_estimator::block_flow_map (&partitioner, vector_fields.at(center), stride, global_map);
+
+        // The error of composition, by composing the flow map of each horizon dividing the integration time to it.
+        for (std::size_t horizon = 0; horizon < horizons.size(); ++horizon)
+        {
+          if (horizons[horizon] == iterations || iterations % horizons[horizon] != 0)
+            continue;
+
+          const auto global_horizon_map = ftle_estimator::gather_flow_map(&partitioner, vector_fields.at(center), stride, output.horizon_particles[horizon]);
+          auto       composed_map       = ftle_estimator::block_flow_map (&partitioner, vector_fields.at(center), stride, global_horizon_map);
+          for (dpa::size count = 1; count < iterations / horizons[horizon]; ++count)
+            composed_map = ftle_estimator::compose(composed_map, global_horizon_map);
+
+          const auto error = ftle_estimator::compare(&partitioner, composed_map, block_map);
+          std::cout << "compose_ftle horizon " << horizons[horizon] << " maximum error " << error.maximum << " root mean square error " << error.root_mean_square << "\n";
+          recorder.set("compose_ftle_horizon_" + std::to_string(horizons[horizon]) + "_maximum_error"         , error.maximum         );
+          recorder.set("compose_ftle_horizon_" + std::to_string(horizons[horizon]) + "_root_mean_square_error", error.root_mean_square);
+        }
+
+        auto composed_map = block_map;
+        for (dpa::size count = 2; count <= *arguments.ftle_estimator_compositions; ++count)
+        {
+          std::cout << "estimate_ftle composed " << count * iterations << "\n";
+          composed_map = ftle_estimator::compose(composed_map, global_map);
+          save_ftle(ftle_estimator::estimate_block(&partitioner, vector_fields.at(center), count * iterations, stride, arguments.particle_advector_step_size, composed_map), std::filesystem::path(arguments.output_dataset_filepath).replace_extension().string() + ".composed_" + std::to_string(count * iterations) + ".h5");
+        }
+      });
+
+    // The FTLE of each local particle at its seed, e.g. [OUTPUT].deformation.rank_0_points.h5.
+    std::cout << "estimate_ftle_from_deformations\n";
+    if (arguments.particle_advector_integrate_deformation)
+      recorder.record("estimate_ftle_from_deformations_time", [&] ()
+      {
+        point_cloud_saver(&partitioner, std::filesystem::path(arguments.output_dataset_filepath).replace_extension().string() + ".deformation.h5").save(
+          ftle_estimator::estimate_from_deformations(arguments.seed_generation_iterations, arguments.particle_advector_step_size, output.inactive_particles));
+      });
   }, 1);
   benchmark_session.gather();
   benchmark_session.to_csv(arguments.output_dataset_filepath + ".benchmark.csv");
@@ -29,6 +29,36 @@ arguments argument_parser::parse(const std::string& filepath)
   arguments.seed_generation_iterations            = boost::lexical_cast<std::size_t>(json["seed_generation_iterations"           ].get<std::string>());
   arguments.particle_advector_particles_per_round = boost::lexical_cast<std::size_t>(json["particle_advector_particles_per_round"].get<std::string>());
 
+  // Optional arguments default to the behavior prior to their introduction.
+  arguments.numa_pinning                            = json.contains("numa_pinning"                           ) ? json["numa_pinning"                           ].get<bool>       () : false;
+  arguments.huge_pages                              = json.contains("huge_pages"                             ) ? json["huge_pages"                             ].get<bool>       () : false;
+  arguments.particle_advector_generate_indices      = json.contains("particle_advector_generate_indices"     ) ? json["particle_advector_generate_indices"     ].get<bool>       () : false;
+  arguments.particle_advector_attribute             = json.contains("particle_advector_attribute"            ) ? json["particle_advector_attribute"            ].get<std::string>() : "none";
+  arguments.particle_advector_recording             = json.contains("particle_advector_recording"            ) ? json["particle_advector_recording"            ].get<std::string>() : "all";
+  arguments.particle_advector_recording_parameter   = json.contains("particle_advector_recording_parameter"  ) ? json["particle_advector_recording_parameter"  ].get<scalar>     () : 1;
+  arguments.particle_advector_quantize              = json.contains("particle_advector_quantize"             ) ? json["particle_advector_quantize"             ].get<bool>       () : false;
+  arguments.particle_advector_integrate_deformation = json.contains("particle_advector_integrate_deformation") ? json["particle_advector_integrate_deformation"].get<bool>       () : false;
+  arguments.particle_advector_interpolation         = json.contains("particle_advector_interpolation"        ) ? json["particle_advector_interpolation"        ].get<std::string>() : "linear";
+  arguments.integral_curve_stitching                = json.contains("integral_curve_stitching"               ) ? json["integral_curve_stitching"               ].get<bool>       () : false;
+  arguments.integral_curve_saver_streaming          = json.contains("integral_curve_saver_streaming"         ) ? json["integral_curve_saver_streaming"         ].get<bool>       () : false;
+  arguments.integral_curve_saver_shared             = json.contains("integral_curve_saver_shared"            ) ? json["integral_curve_saver_shared"            ].get<bool>       () : false;
+  arguments.integral_curve_saver_compression        = json.contains("integral_curve_saver_compression"       ) ? json["integral_curve_saver_compression"       ].get<std::string>() : "none";
+  arguments.integral_curve_saver_spatial_index      = json.contains("integral_curve_saver_spatial_index"     ) ? json["integral_curve_saver_spatial_index"     ].get<bool>       () : false;
+  arguments.ftle_estimator_distributed              = json.contains("ftle_estimator_distributed"             ) ? json["ftle_estimator_distributed"             ].get<bool>       () : false;
+  arguments.regular_grid_saver_shared               = json.contains("regular_grid_saver_shared"              ) ? json["regular_grid_saver_shared"              ].get<bool>       () : false;
+  arguments.input_dataset_axis_order                = json.contains("input_dataset_axis_order"               ) ? json["input_dataset_axis_order"               ].get<std::string>() : "xyz";
+  arguments.input_dataset_component_order           = json.contains("input_dataset_component_order"          ) ? json["input_dataset_component_order"          ].get<std::string>() : "zyx";
+  arguments.input_dataset_cache_preprocess          = json.contains("input_dataset_cache_preprocess"         ) ? json["input_dataset_cache_preprocess"         ].get<bool>       () : false;
+  arguments.input_dataset_time_spacing              = json.contains("input_dataset_time_spacing"             ) ? json["input_dataset_time_spacing"             ].get<scalar>     () : 1;
+
+  if (json.contains("thread_count"))
+    arguments.thread_count = boost::lexical_cast<std::size_t>(json["thread_count"].get<std::string>());
+  if (json.contains("integral_curve_saver_mantissa_bits"))
+    arguments.integral_curve_saver_mantissa_bits = boost::lexical_cast<std::size_t>(json["integral_curve_saver_mantissa_bits"].get<std::string>());
+  if (json.contains("ftle_estimator_compositions"))
+    arguments.ftle_estimator_compositions = boost::lexical_cast<std::size_t>(json["ftle_estimator_compositions"].get<std::string>());
+  if (json.contains("input_dataset_cache_directory"))
+    arguments.input_dataset_cache_directory = json["input_dataset_cache_directory"].get<std::string>();
   if (json.contains("seed_generation_stride"))
   {
     auto stride = json["seed_generation_stride"];
@@ -46,6 +76,9 @@ arguments argument_parser::parse(const std::string& filepath)
       boost::lexical_cast<std::size_t>(range[0].get<std::string>()), 
       boost::lexical_cast<std::size_t>(range[1].get<std::string>()));
   }
+  if (json.contains("ftle_estimator_horizons"))
+    for (auto& horizon : json["ftle_estimator_horizons"])
+      arguments.ftle_estimator_horizons.push_back(boost::lexical_cast<std::size_t>(horizon.get<std::string>()));
   if (json.contains("seed_generation_boundaries"))
   {
     auto boundaries = json["seed_generation_boundaries"];
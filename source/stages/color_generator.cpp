@@ -1,8 +1,12 @@
 #include <dpa/stages/color_generator.hpp>
 
+#include <algorithm>
+#include <functional>
 #include <variant>
 #include <vector>
 
+#include <boost/mpi/cartesian_communicator.hpp>
+#include <mpi.h>
 #include <tbb/tbb.h>
 
 #include <dpa/types/basic_types.hpp>
@@ -16,7 +20,8 @@ void color_generator::generate_from_tangents          (integral_curves& integral
 {
   for (auto& integral_curve : integral_curves)
   {
-    auto& vertices = integral_curve.vertices;
+    integral_curve::vertex_vector decoded_vertices;
+    auto& vertices = integral_curve.decoded_vertices(decoded_vertices);
     auto& colors   = integral_curve.colors  ;
 
     colors = std::vector<bvector3>(vertices.size());
@@ -38,7 +43,8 @@ void color_generator::generate_from_angular_velocities(integral_curves& integral
 {
   for (auto& integral_curve : integral_curves)
   {
-    auto& vertices = integral_curve.vertices;
+    integral_curve::vertex_vector decoded_vertices;
+    auto& vertices = integral_curve.decoded_vertices(decoded_vertices);
     auto& colors   = integral_curve.colors  ;
 
     colors = std::vector<scalar>(vertices.size());
@@ -60,7 +66,8 @@ void color_generator::generate_from_velocities        (integral_curves& integral
 {
   for (auto& integral_curve : integral_curves)
   {
-    auto& vertices = integral_curve.vertices;
+    integral_curve::vertex_vector decoded_vertices;
+    auto& vertices = integral_curve.decoded_vertices(decoded_vertices);
     auto& colors   = integral_curve.colors  ;
 
     colors = std::vector<scalar>(vertices.size(), 0);
@@ -73,15 +80,47 @@ void color_generator::generate_from_velocities        (integral_curves& integral
     });
   }
 }
-void color_generator::generate_from_potentials        (integral_curves& integral_curves, const std::unordered_map<relative_direction, regular_vector_field_3d>& vector_fields)
+void color_generator::generate_from_potentials        (integral_curves& integral_curves, const std::unordered_map<relative_direction, regular_vector_field_3d>& vector_fields, domain_partitioner* partitioner)
 {
-  std::unordered_map<relative_direction, regular_scalar_field_3d> scalar_fields;
-  for (auto& entry : vector_fields)
-    scalar_fields[entry.first] = entry.second.potential();
+  // The potentials are cached on the fields, hence referenced rather than copied.
+  std::unordered_map<relative_direction, const regular_scalar_field_3d*> scalar_fields;
+  if (partitioner)
+  {
+    // The lines of the next block along each dimension start at its ghosted offset, which is within this block.
+    const auto& partition = partitioner->partitions().at(center);
+    const auto& ghost     = partitioner->ghost_cell_size();
+    regular_scalar_field_3d::index_type handover;
+    for (auto i = 0; i < 3; ++i)
+    {
+      const auto next_offset = partition.offset[i] + partitioner->block_size()[i];
+      handover[i] = (next_offset >= ghost[i] ? next_offset - ghost[i] : 0) - partition.ghosted_offset[i];
+    }
+
+    const auto line_offsets = [&] (const std::size_t dimension, const std::vector<scalar>& bases, const std::vector<scalar>& increments)
+    {
+      boost::mpi::cartesian_communicator communicator(*partitioner->cartesian_communicator(), std::vector<int> {static_cast<int>(dimension)});
+
+      auto contributions = increments;
+      if (communicator.rank() == 0)
+        std::transform(contributions.begin(), contributions.end(), bases.begin(), contributions.begin(), std::plus<scalar>());
+
+      std::vector<scalar> starts(contributions.size());
+      MPI_Exscan(contributions.data(), starts.data(), static_cast<int>(contributions.size()), MPI_FLOAT, MPI_SUM, communicator);
+      return communicator.rank() == 0 ? bases : starts;
+    };
+
+    scalar_fields.emplace(center, &vector_fields.at(center).potential(line_offsets, handover));
+  }
+  else
+  {
+    for (auto& entry : vector_fields)
+      scalar_fields.emplace(entry.first, &entry.second.potential());
+  }
 
   for (auto& integral_curve : integral_curves)
   {
-    auto& vertices = integral_curve.vertices;
+    integral_curve::vertex_vector decoded_vertices;
+    auto& vertices = integral_curve.decoded_vertices(decoded_vertices);
     auto& colors   = integral_curve.colors  ;
 
     colors = std::vector<scalar>(vertices.size(), 0);
@@ -89,8 +128,8 @@ void color_generator::generate_from_potentials        (integral_curves& integral
     {
       if (vertices[vertex_index] != terminal_value<vector3>())
         for (auto& scalar_field : scalar_fields)
-          if (scalar_field.second.contains(vertices[vertex_index]))
-            std::get<std::vector<scalar>>(colors)[vertex_index] = scalar_field.second.interpolate(vertices[vertex_index]);
+          if (scalar_field.second->contains(vertices[vertex_index]))
+            std::get<std::vector<scalar>>(colors)[vertex_index] = scalar_field.second->interpolate(vertices[vertex_index]);
     });
   }
 }
@@ -0,0 +1,170 @@
+#include <dpa/stages/curve_stitcher.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include <boost/mpi.hpp>
+#include <boost/serialization/vector.hpp>
+#include <tbb/tbb.h>
+
+#undef min
+#undef max
+
+namespace dpa
+{
+// The polylines sent from one rank to another.
+struct polyline_buffer
+{
+  // Function for boost::serialization which is used by boost::mpi.
+  template<class archive_type>
+  void serialize(archive_type& archive, const std::uint32_t version)
+  {
+    archive & headers ;
+    archive & vertices;
+    archive & colors  ;
+  }
+
+  std::vector<std::uint64_t> headers ; // Id, segment and vertex count (including the terminal vertex) per polyline.
+  std::vector<scalar>        vertices;
+  std::vector<scalar>        colors  ;
+};
+
+integral_curves curve_stitcher::stitch(const integral_curves& integral_curves, const boost::mpi::communicator& communicator, const bool use_64_bit_indices)
+{
+  // Colors are carried only if every rank has scalar colors for all of its vertices (e.g. generated during advection).
+  const auto local_colors = std::all_of(integral_curves.begin(), integral_curves.end(), [ ] (const integral_curve& curve)
+  {
+    return curve.vertex_count() == 0 || (std::holds_alternative<std::vector<scalar>>(curve.colors) && std::get<std::vector<scalar>>(curve.colors).size() == curve.vertex_count());
+  });
+  const auto use_colors   = boost::mpi::all_reduce(communicator, local_colors, std::logical_and<bool>());
+  auto       quantized    = std::any_of(integral_curves.begin(), integral_curves.end(), [ ] (const integral_curve& curve) { return curve.quantized(); });
+
+  std::vector<polyline_buffer> sent    (communicator.size());
+  std::vector<polyline_buffer> received(communicator.size());
+  for (auto& curve : integral_curves)
+  {
+    integral_curve::vertex_vector decoded_vertices;
+    const auto& vertices = curve.decoded_vertices(decoded_vertices);
+    for (std::size_t polyline_index = 0; polyline_index < curve.polyline_ids.size(); ++polyline_index)
+    {
+      const auto begin  = curve.polyline_offsets[polyline_index    ];
+      const auto end    = curve.polyline_offsets[polyline_index + 1];
+      auto&      buffer = sent[curve.polyline_ids[polyline_index] % communicator.size()];
+      buffer.headers .insert(buffer.headers .end(), {curve.polyline_ids[polyline_index], curve.polyline_segments[polyline_index], end - begin});
+      buffer.vertices.insert(buffer.vertices.end(), vertices[begin].data(), vertices[begin].data() + 3 * (end - begin));
+      if (use_colors)
+        buffer.colors.insert(buffer.colors.end(), std::get<std::vector<scalar>>(curve.colors).begin() + begin, std::get<std::vector<scalar>>(curve.colors).begin() + end);
+    }
+  }
+
+  boost::mpi::all_to_all(communicator, sent, received);
+  sent.clear();
+  quantized = boost::mpi::all_reduce(communicator, quantized, std::logical_or<bool>());
+
+  struct polyline_segment
+  {
+    std::uint64_t id      ;
+    std::uint64_t sequence;
+    std::size_t   buffer  ;
+    std::size_t   offset  ; // In vertices, within the buffer.
+    std::size_t   count   ; // Including the terminal vertex.
+  };
+  std::vector<polyline_segment> segments;
+  for (std::size_t buffer_index = 0; buffer_index < received.size(); ++buffer_index)
+  {
+    auto offset = std::size_t(0);
+    for (std::size_t i = 0; i < received[buffer_index].headers.size(); i += 3)
+    {
+      const auto& headers = received[buffer_index].headers;
+      segments.push_back(polyline_segment {headers[i], headers[i + 1], buffer_index, offset, headers[i + 2]});
+      offset += headers[i + 2];
+    }
+  }
+  tbb::parallel_sort(segments.begin(), segments.end(), [ ] (const polyline_segment& lhs, const polyline_segment& rhs)
+  {
+    return lhs.id < rhs.id || (lhs.id == rhs.id && lhs.sequence < rhs.sequence);
+  });
+
+  // Each segment contributes its vertices without the terminal one, and without the first one unless it begins the
+  // polyline (as it duplicates the last one of the preceding segment). The last segment also appends a terminal vertex.
+  const auto first = [&] (const std::size_t i) { return i == 0                   || segments[i].id != segments[i - 1].id; };
+  const auto last  = [&] (const std::size_t i) { return i == segments.size() - 1 || segments[i].id != segments[i + 1].id; };
+
+  std::vector<std::size_t> vertex_offsets  (segments.size() + 1, 0);
+  std::vector<std::size_t> index_offsets   (segments.size() + 1, 0);
+  std::vector<std::size_t> polyline_offsets(segments.size() + 1, 0);
+  tbb::parallel_for(std::size_t(0), segments.size(), std::size_t(1), [&] (const std::size_t i)
+  {
+    const auto skipped      = first(i) ? std::size_t(0) : std::size_t(1);
+    const auto copied       = std::max(segments[i].count, skipped + 1) - skipped - 1;
+    vertex_offsets  [i + 1] = copied + (last(i) ? 1 : 0);
+    index_offsets   [i + 1] = 2 * (first(i) ? std::max(copied, std::size_t(1)) - 1 : copied);
+    polyline_offsets[i + 1] = first(i) ? 1 : 0;
+  });
+  std::partial_sum(vertex_offsets  .begin(), vertex_offsets  .end(), vertex_offsets  .begin());
+  std::partial_sum(index_offsets   .begin(), index_offsets   .end(), index_offsets   .begin());
+  std::partial_sum(polyline_offsets.begin(), polyline_offsets.end(), polyline_offsets.begin());
+
+  dpa::integral_curves stitched_curves(1);
+  auto& curve = stitched_curves.back();
+  curve.vertices          = integral_curve::vertex_vector(allocator<vector3>(allocation_policy {true, false}));
+  curve.vertices.resize(vertex_offsets.back());
+  curve.polyline_ids      = std::vector<std::uint64_t>(polyline_offsets.back());
+  curve.polyline_segments = std::vector<std::uint32_t>(polyline_offsets.back(), 0);
+  curve.polyline_offsets  = std::vector<std::size_t>  (polyline_offsets.back() + 1, vertex_offsets.back());
+  if (use_colors)
+    curve.colors = std::vector<scalar>(vertex_offsets.back());
+  if (use_64_bit_indices || vertex_offsets.back() > std::numeric_limits<std::uint32_t>::max())
+    curve.indices = std::vector<std::uint64_t>(index_offsets.back());
+  else
+    curve.indices = std::vector<std::uint32_t>(index_offsets.back());
+
+  tbb::parallel_for(std::size_t(0), segments.size(), std::size_t(1), [&] (const std::size_t i)
+  {
+    const auto& segment = segments[i];
+    const auto& buffer  = received[segment.buffer];
+    const auto  skipped = first(i) ? std::size_t(0) : std::size_t(1);
+    const auto  copied  = std::max(segment.count, skipped + 1) - skipped - 1;
+    const auto  source  = segment.offset + skipped;
+    const auto  target  = vertex_offsets[i];
+
+    for (std::size_t j = 0; j < copied; ++j)
+      curve.vertices[target + j] = vector3(buffer.vertices[3 * (source + j)], buffer.vertices[3 * (source + j) + 1], buffer.vertices[3 * (source + j) + 2]);
+    if (last(i))
+      curve.vertices[target + copied] = terminal_value<vector3>();
+
+    if (use_colors)
+    {
+      std::copy(buffer.colors.begin() + source, buffer.colors.begin() + source + copied, std::get<std::vector<scalar>>(curve.colors).begin() + target);
+      if (last(i))
+        std::get<std::vector<scalar>>(curve.colors)[target + copied] = scalar(0);
+    }
+
+    // Every copied vertex but the first one of a polyline ends a line segment.
+    std::visit([&] (auto& cast_indices)
+    {
+      auto index_offset = index_offsets[i];
+      for (std::size_t j = first(i) ? 1 : 0; j < copied; ++j)
+      {
+        cast_indices[index_offset++] = target + j - 1;
+        cast_indices[index_offset++] = target + j;
+      }
+    }, curve.indices);
+
+    if (first(i))
+    {
+      curve.polyline_ids    [polyline_offsets[i]] = segment.id;
+      curve.polyline_offsets[polyline_offsets[i]] = target;
+    }
+  });
+
+  if (quantized)
+    curve.quantize();
+
+  return stitched_curves;
+}
+}
@@ -58,6 +58,10 @@ const svector3&                                                              dom
 {                                    
   return domain_size_;               
 }                                    
+const svector3&                                                              domain_partitioner::ghost_cell_size       () const
+{                                    
+  return ghost_cell_size_;           
+}                                    
 const svector3&                                                              domain_partitioner::grid_size             () const
 {                                    
   return grid_size_;                 
@@ -1,15 +1,176 @@
 #include <dpa/stages/ftle_estimator.hpp>
 
-#include <Eigen/Dense>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <boost/mpi/collectives.hpp>
+#include <boost/mpi/operations.hpp>
+#include <mpi.h>
+
+#include <dpa/math/cauchy_green_ftle.hpp>
+#include <dpa/math/symmetric_eigenvalues.hpp>
+
+#undef min
+#undef max
 
 namespace dpa
 {
+// Rows are processed in tiles of this many cells along z.
+constexpr std::size_t row_tile_size = 64;
+
+// Estimates the FTLE of the cells [z_begin, z_end) of a row of the flow map into the (contiguous) output. The gradient
+// is fused: the right Cauchy-Green tensor (the Gram matrix of the partial derivatives, i.e. of the gradient's columns)
+// is accumulated per tile into arrays, followed by the vectorized cauchy_green_ftle. The neighbors function returns
+// the previous and next index along a dimension and the inverse of their distance.
+template <typename neighbors_type>
+static void estimate_row(const regular_vector_field_3d& flow_map, const std::size_t x, const std::size_t y, const std::size_t z_begin, const std::size_t z_end, const neighbors_type& neighbors, const scalar inverse_time, scalar* output)
+{
+  std::array<scalar, row_tile_size> c00, c01, c02, c11, c12, c22;
+  for (auto tile_begin = z_begin; tile_begin < z_end; tile_begin += row_tile_size)
+  {
+    const auto tile_end = std::min(tile_begin + row_tile_size, z_end);
+    for (auto z = tile_begin; z < tile_end; ++z)
+    {
+      const auto index = std::array<std::size_t, 3> {x, y, z};
+
+      std::array<vector3, 3> derivatives;
+      for (std::size_t dimension = 0; dimension < 3; ++dimension)
+      {
+        const auto [prev_index, next_index, inverse_distance] = neighbors(index, dimension);
+        derivatives[dimension] = (flow_map.data(next_index) - flow_map.data(prev_index)) * inverse_distance;
+      }
+
+      const auto i = z - tile_begin;
+      c00[i] = derivatives[0].dot(derivatives[0]);
+      c01[i] = derivatives[0].dot(derivatives[1]);
+      c02[i] = derivatives[0].dot(derivatives[2]);
+      c11[i] = derivatives[1].dot(derivatives[1]);
+      c12[i] = derivatives[1].dot(derivatives[2]);
+      c22[i] = derivatives[2].dot(derivatives[2]);
+    }
+
+    cauchy_green_ftle(c00.data(), c01.data(), c02.data(), c11.data(), c12.data(), c22.data(), tile_end - tile_begin, inverse_time, output + (tile_begin - z_begin));
+  }
+}
+
+#ifdef DPA_FTLE_SUPPORT
+// The strided cells of the (non-ghosted) block, which are seeded at offset + stride * index (see
+// uniform_seed_generator::generate), and their memory offset within the ghosted layout of estimate.
+struct strided_block
+{
+  std::array<std::size_t, 3> shape        ;
+  std::array<std::size_t, 3> memory_offset;
+  vector3                    offset       ;
+  vector3                    spacing      ;
+};
+static strided_block make_strided_block(domain_partitioner* partitioner, const regular_vector_field_3d& original_vector_field, const vector3& seed_stride)
+{
+  const auto& partition  = partitioner->partitions().at(center);
+  const auto& block_size = partitioner->block_size();
+
+  strided_block block;
+  block.spacing = vector3(original_vector_field.spacing.array() * seed_stride.array());
+  for (auto i = 0; i < 3; ++i)
+  {
+    block.shape        [i] = size(scalar(block_size[i]) / seed_stride[i]);
+    block.memory_offset[i] = size(scalar(partition.offset[i] - partition.ghosted_offset[i]) / seed_stride[i]);
+    block.offset       [i] = original_vector_field.spacing[i] * scalar(partition.offset[i]);
+  }
+  return block;
+}
+// The int counts and displacements of MPI for the particle counts per rank (of a contiguous type of six floats), whose
+// total must fit into int. Returns the total.
+static std::uint64_t mpi_particle_counts(const std::vector<std::uint64_t>& particle_counts, std::vector<int>& counts, std::vector<int>& displacements, const std::string& operation)
+{
+  const auto total_count = std::accumulate(particle_counts.begin(), particle_counts.end(), std::uint64_t(0));
+  if (total_count > std::uint64_t(std::numeric_limits<int>::max()))
+    throw std::overflow_error("The " + operation + " of " + std::to_string(total_count) + " particles exceeds the " + std::to_string(std::numeric_limits<int>::max()) + " particles MPI can address. Increase the seed stride.");
+
+  counts       .resize(particle_counts.size());
+  displacements.assign(particle_counts.size(), 0);
+  for (std::size_t rank = 0; rank < particle_counts.size(); ++rank)
+  {
+    counts[rank] = int(particle_counts[rank]);
+    if (rank > 0)
+      displacements[rank] = displacements[rank - 1] + counts[rank - 1];
+  }
+  return total_count;
+}
+
+static std::array<std::size_t, 3> padded_block_shape(const strided_block& block)
+{
+  return {block.shape[0] + 2, block.shape[1] + 2, block.shape[2] + 2};
+}
+// Whether the block has a face neighbor below and above along each dimension, i.e. is not at the domain boundary.
+static std::pair<std::array<bool, 3>, std::array<bool, 3>> block_neighbors(domain_partitioner* partitioner)
+{
+  const auto& multi_rank = partitioner->partitions().at(center).multi_rank;
+  const auto& grid_size  = partitioner->grid_size();
+
+  std::array<bool, 3> lower_neighbor, upper_neighbor;
+  for (auto i = 0; i < 3; ++i)
+  {
+    lower_neighbor[i] = multi_rank[i] > 0;
+    upper_neighbor[i] = std::size_t(multi_rank[i]) + 1 < grid_size[i];
+  }
+  return {lower_neighbor, upper_neighbor};
+}
+
+// Estimates the FTLE of the strided cells of the block from its flow map padded by a one cell halo, into the ghosted
+// layout of estimate. Central differences across the halo, one-sided at the domain boundaries (the halos without
+// neighbor).
+static regular_scalar_field_3d estimate_padded_block(domain_partitioner* partitioner, const regular_vector_field_3d& original_vector_field, const vector3& seed_stride, const regular_vector_field_3d& flow_map, const std::array<bool, 3>& lower_neighbor, const std::array<bool, 3>& upper_neighbor, const scalar time)
+{
+  const auto block          = make_strided_block(partitioner, original_vector_field, seed_stride);
+  const auto original_shape = original_vector_field.data.shape();
+
+  std::array<std::size_t, 3> strided_shape;
+  for (auto i = 0; i < 3; ++i)
+    strided_shape[i] = size(scalar(original_shape[i]) / seed_stride[i]);
+
+  auto ftle_map = regular_scalar_field_3d
+  (
+    strided_shape                ,
+    original_vector_field.offset ,
+    original_vector_field.size   ,
+    block.spacing
+  );
+  const auto neighbors = [&] (const std::array<std::size_t, 3>& index, const std::size_t dimension)
+  {
+    auto prev_index = index, next_index = index;
+    if (index[dimension] > 1                      || lower_neighbor[dimension]) prev_index[dimension] -= 1;
+    if (index[dimension] < block.shape[dimension] || upper_neighbor[dimension]) next_index[dimension] += 1;
+    const auto distance = scalar(next_index[dimension] - prev_index[dimension]) * block.spacing[dimension];
+    return std::make_tuple(prev_index, next_index, distance > scalar(0) ? scalar(1) / distance : scalar(0));
+  };
+  const auto inverse_time = scalar(1) / std::abs(time);
+  tbb::parallel_for(tbb::blocked_range2d<std::size_t>(1, block.shape[0] + 1, 1, block.shape[1] + 1), [&] (const tbb::blocked_range2d<std::size_t>& range)
+  {
+    for (auto x = range.rows().begin(); x < range.rows().end(); ++x)
+    for (auto y = range.cols().begin(); y < range.cols().end(); ++y)
+      estimate_row(flow_map, x, y, 1, block.shape[2] + 1, neighbors, inverse_time, &ftle_map.data(std::array<std::size_t, 3> {block.memory_offset[0] + x - 1, block.memory_offset[1] + y - 1, block.memory_offset[2]}));
+  });
+  return ftle_map;
+}
+#endif
+
 regular_scalar_field_3d ftle_estimator::estimate(
   const regular_vector_field_3d&             original_vector_field  , 
   const std::size_t                          seed_maximum_iterations, 
   const vector3&                             seed_stride            , 
   const scalar                               step_size              , 
-  const tbb::concurrent_vector<particle_3d>& local_particles        )     
+  const tbb::concurrent_vector<particle_3d>& local_particles        )
 {
 #if DPA_FTLE_SUPPORT
   auto original_shape = original_vector_field.data.shape();
@@ -19,22 +180,22 @@ regular_scalar_field_3d ftle_estimator::estimate(
     size(scalar(original_shape[1]) / seed_stride[1]),
     size(scalar(original_shape[2]) / seed_stride[2])
   };
-  auto strided_spacing = original_vector_field.spacing.array() * seed_stride.array();
+  auto strided_spacing = vector3(original_vector_field.spacing.array() * seed_stride.array());
 
   auto flow_map = regular_vector_field_3d
-  {
-    boost::multi_array<vector3, 3>(strided_shape),
+  (
+    strided_shape                ,
     original_vector_field.offset ,
     original_vector_field.size   ,
     strided_spacing
-  };
+  );
   auto ftle_map = regular_scalar_field_3d
-  {
-    boost::multi_array<scalar, 3>(strided_shape),
+  (
+    strided_shape                ,
     original_vector_field.offset ,
     original_vector_field.size   ,
     strided_spacing
-  };
+  );
 
   tbb::parallel_for(std::size_t(0), local_particles.size(), std::size_t(1), [&] (const std::size_t index)
   {
@@ -42,19 +203,20 @@ regular_scalar_field_3d ftle_estimator::estimate(
     flow_map.cell(particle.original_position) = particle.position;
   });
   
-  auto flow_map_gradient = flow_map.gradient();
-  flow_map_gradient.apply([&] (const std::array<std::size_t, 3>& index, const matrix3& value)
+  // Central differences, clamped to the boundaries of the field.
+  const auto neighbors = [&] (const std::array<std::size_t, 3>& index, const std::size_t dimension)
   {
-    // Compute the spectral norm (right Cauchy-Green tensor).
-    const matrix3 right_cauchy_green = value.transpose().eval() * value;
-  
-    // Compute eigenvalues and eigenvectors.
-    const Eigen::SelfAdjointEigenSolver<matrix3> solver(right_cauchy_green);
-    const auto eigenvalues  = solver.eigenvalues ();
-    const auto eigenvectors = solver.eigenvectors();
-  
-    // Compute FTLE.
-    ftle_map.data(index) = std::log(std::sqrt(eigenvalues.maxCoeff())) / std::abs(step_size * (seed_maximum_iterations - 0)); // TODO: Subtract remaining iterations of associated particle.
+    auto prev_index = index, next_index = index;
+    if (index[dimension] > 0)                            prev_index[dimension] -= 1;
+    if (index[dimension] < strided_shape[dimension] - 1) next_index[dimension] += 1;
+    return std::make_tuple(prev_index, next_index, scalar(1) / (scalar(2) * strided_spacing[dimension]));
+  };
+  const auto inverse_time = scalar(1) / std::abs(step_size * (seed_maximum_iterations - 0)); // TODO: Subtract remaining iterations of associated particle.
+  tbb::parallel_for(tbb::blocked_range2d<std::size_t>(0, strided_shape[0], 0, strided_shape[1]), [&] (const tbb::blocked_range2d<std::size_t>& range)
+  {
+    for (auto x = range.rows().begin(); x < range.rows().end(); ++x)
+    for (auto y = range.cols().begin(); y < range.cols().end(); ++y)
+      estimate_row(flow_map, x, y, 0, strided_shape[2], neighbors, inverse_time, &ftle_map.data(std::array<std::size_t, 3> {x, y, 0}));
   });
 
   return ftle_map;
@@ -63,4 +225,339 @@ regular_scalar_field_3d ftle_estimator::estimate(
   return regular_scalar_field_3d();
 #endif
 }
+
+regular_scalar_field_3d ftle_estimator::estimate_distributed(
+  domain_partitioner*                        partitioner            ,
+  const regular_vector_field_3d&             original_vector_field  , 
+  const std::size_t                          seed_maximum_iterations, 
+  const vector3&                             seed_stride            , 
+  const scalar                               step_size              , 
+  const tbb::concurrent_vector<particle_3d>& local_particles        )
+{
+#if DPA_FTLE_SUPPORT
+  const auto& communicator = *partitioner->cartesian_communicator();
+  const auto  block        = make_strided_block(partitioner, original_vector_field, seed_stride);
+
+  // Counting sort of the original and final positions by original rank, counted in particles (see mpi_particle_counts).
+  const auto rank_count = static_cast<std::size_t>(communicator.size());
+  tbb::enumerable_thread_specific<std::vector<std::uint64_t>> thread_counts(std::vector<std::uint64_t>(rank_count, 0));
+  tbb::parallel_for(std::size_t(0), local_particles.size(), std::size_t(1), [&] (const std::size_t index)
+  {
+    ++thread_counts.local()[local_particles[index].original_rank];
+  });
+  std::vector<std::uint64_t> send_particle_counts(rank_count, 0);
+  for (auto& counts : thread_counts)
+    for (std::size_t rank = 0; rank < rank_count; ++rank)
+      send_particle_counts[rank] += counts[rank];
+
+  std::vector<std::uint64_t> receive_particle_counts(rank_count);
+  MPI_Alltoall(send_particle_counts.data(), 1, MPI_UINT64_T, receive_particle_counts.data(), 1, MPI_UINT64_T, communicator);
+
+  std::vector<int> send_counts, send_displacements, receive_counts, receive_displacements;
+  mpi_particle_counts(send_particle_counts, send_counts, send_displacements, "exchange of the flow map");
+  const auto receive_count = mpi_particle_counts(receive_particle_counts, receive_counts, receive_displacements, "exchange of the flow map");
+
+  const auto cursors = std::make_unique<std::atomic<std::size_t>[]>(rank_count);
+  for (std::size_t rank = 0; rank < rank_count; ++rank)
+    cursors[rank] = std::size_t(send_displacements[rank]);
+
+  // Six floats per particle: the original position followed by the final position.
+  std::vector<float> sent    (6 * local_particles.size());
+  std::vector<float> received(6 * receive_count);
+  tbb::parallel_for(std::size_t(0), local_particles.size(), std::size_t(1), [&] (const std::size_t index)
+  {
+    const auto& particle = local_particles[index];
+    const auto  offset   = 6 * cursors[particle.original_rank].fetch_add(1);
+    for (auto i = 0; i < 3; ++i)
+    {
+      sent[offset     + i] = particle.original_position[i];
+      sent[offset + 3 + i] = particle.position         [i];
+    }
+  });
+
+  MPI_Datatype particle_type;
+  MPI_Type_contiguous(6, MPI_FLOAT, &particle_type);
+  MPI_Type_commit    (&particle_type);
+  MPI_Alltoallv(sent.data(), send_counts.data(), send_displacements.data(), particle_type, received.data(), receive_counts.data(), receive_displacements.data(), particle_type, communicator);
+  MPI_Type_free      (&particle_type);
+  sent.clear();
+
+  // The flow map of the block padded by the halo.
+  auto flow_map = regular_vector_field_3d
+  (
+    padded_block_shape(block)     ,
+    block.offset - block.spacing  ,
+    original_vector_field.size    ,
+    block.spacing
+  );
+  tbb::parallel_for(std::size_t(0), received.size() / 6, std::size_t(1), [&] (const std::size_t index)
+  {
+    std::array<std::size_t, 3> cell;
+    for (auto i = 0; i < 3; ++i)
+    {
+      const auto subscript = std::round((received[6 * index + i] - block.offset[i]) / block.spacing[i]);
+      if (subscript < scalar(0) || subscript >= scalar(block.shape[i]))
+        return;
+      cell[i] = std::size_t(subscript) + 1;
+    }
+    flow_map.data(cell) = vector3(received[6 * index + 3], received[6 * index + 4], received[6 * index + 5]);
+  });
+  received.clear();
+
+  // Exchanges the faces of the block with the face neighbors, into the halo. Edges and corners are not required by the
+  // central differences. Halos without neighbor (at the domain boundaries) remain unused.
+  std::array<bool, 3> lower_neighbor, upper_neighbor;
+  for (auto dimension = 0; dimension < 3; ++dimension)
+  {
+    const auto [lower, upper] = communicator.shifted_ranks(dimension, 1);
+    lower_neighbor[dimension] = lower != MPI_PROC_NULL;
+    upper_neighbor[dimension] = upper != MPI_PROC_NULL;
+
+    const auto u = (dimension + 1) % 3, v = (dimension + 2) % 3;
+    const auto face_size = block.shape[u] * block.shape[v];
+    const auto copy_face = [&] (const std::size_t layer, std::vector<float>& buffer, const bool pack)
+    {
+      tbb::parallel_for(std::size_t(0), face_size, std::size_t(1), [&] (const std::size_t face_index)
+      {
+        std::array<std::size_t, 3> cell;
+        cell[dimension] = layer;
+        cell[u]         = face_index / block.shape[v] + 1;
+        cell[v]         = face_index % block.shape[v] + 1;
+        auto& element = flow_map.data(cell);
+        for (auto i = 0; i < 3; ++i)
+        {
+          if (pack) buffer[3 * face_index + i] = element[i];
+          else      element[i] = buffer[3 * face_index + i];
+        }
+      });
+    };
+
+    std::vector<float> send_buffer(3 * face_size), receive_buffer(3 * face_size);
+    copy_face(block.shape[dimension], send_buffer, true);
+    MPI_Sendrecv(send_buffer.data(), int(send_buffer.size()), MPI_FLOAT, upper, 0, receive_buffer.data(), int(receive_buffer.size()), MPI_FLOAT, lower, 0, communicator, MPI_STATUS_IGNORE);
+    if (lower_neighbor[dimension])
+      copy_face(0, receive_buffer, false);
+
+    copy_face(1, send_buffer, true);
+    MPI_Sendrecv(send_buffer.data(), int(send_buffer.size()), MPI_FLOAT, lower, 1, receive_buffer.data(), int(receive_buffer.size()), MPI_FLOAT, upper, 1, communicator, MPI_STATUS_IGNORE);
+    if (upper_neighbor[dimension])
+      copy_face(block.shape[dimension] + 1, receive_buffer, false);
+  }
+
+  return estimate_padded_block(partitioner, original_vector_field, seed_stride, flow_map, lower_neighbor, upper_neighbor, step_size * seed_maximum_iterations);
+#else
+  std::cout << "FTLE is not estimated since original positions are unavailable. Declare DPA_FTLE_SUPPORT and rebuild." << std::endl;
+  return regular_scalar_field_3d();
+#endif
+}
+
+regular_vector_field_3d ftle_estimator::gather_flow_map(
+  domain_partitioner*                        partitioner            ,
+  const regular_vector_field_3d&             original_vector_field  , 
+  const vector3&                             seed_stride            , 
+  const tbb::concurrent_vector<particle_3d>& local_particles        )
+{
+#if DPA_FTLE_SUPPORT
+  const auto& communicator = *partitioner->cartesian_communicator();
+  const auto& multi_rank   = partitioner->partitions().at(center).multi_rank;
+  const auto& grid_size    = partitioner->grid_size();
+  const auto  block        = make_strided_block(partitioner, original_vector_field, seed_stride);
+
+  std::array<std::size_t, 3> global_shape;
+  vector3                    global_offset;
+  for (auto i = 0; i < 3; ++i)
+  {
+    global_shape [i] = block.shape[i] * grid_size[i];
+    global_offset[i] = block.offset[i] - block.spacing[i] * scalar(block.shape[i] * multi_rank[i]);
+  }
+
+  // Six floats per particle: the original position followed by the final position.
+  std::vector<float> sent(6 * local_particles.size());
+  tbb::parallel_for(std::size_t(0), local_particles.size(), std::size_t(1), [&] (const std::size_t index)
+  {
+    const auto& particle = local_particles[index];
+    for (auto i = 0; i < 3; ++i)
+    {
+      sent[6 * index     + i] = particle.original_position[i];
+      sent[6 * index + 3 + i] = particle.position         [i];
+    }
+  });
+
+  // Counted in particles (see mpi_particle_counts).
+  const auto          rank_count     = static_cast<std::size_t>(communicator.size());
+  const std::uint64_t particle_count = local_particles.size();
+  std::vector<std::uint64_t> particle_counts(rank_count);
+  MPI_Allgather(&particle_count, 1, MPI_UINT64_T, particle_counts.data(), 1, MPI_UINT64_T, communicator);
+
+  std::vector<int> receive_counts, receive_displacements;
+  const auto total_count = mpi_particle_counts(particle_counts, receive_counts, receive_displacements, "gather of the flow map");
+
+  MPI_Datatype particle_type;
+  MPI_Type_contiguous(6, MPI_FLOAT, &particle_type);
+  MPI_Type_commit    (&particle_type);
+  std::vector<float> received(6 * total_count);
+  MPI_Allgatherv(sent.data(), int(particle_count), particle_type, received.data(), receive_counts.data(), receive_displacements.data(), particle_type, communicator);
+  MPI_Type_free      (&particle_type);
+  sent.clear();
+
+  // Unseeded cells (e.g. outside the seed generation boundaries) map to themselves.
+  auto flow_map = regular_vector_field_3d
+  (
+    global_shape                  ,
+    global_offset                 ,
+    original_vector_field.size    ,
+    block.spacing
+  );
+  flow_map.apply([&] (const std::array<std::size_t, 3>& index, vector3& element)
+  {
+    for (auto i = 0; i < 3; ++i)
+      element[i] = global_offset[i] + block.spacing[i] * scalar(index[i]);
+  });
+  tbb::parallel_for(std::size_t(0), received.size() / 6, std::size_t(1), [&] (const std::size_t index)
+  {
+    std::array<std::size_t, 3> cell;
+    for (auto i = 0; i < 3; ++i)
+    {
+      const auto subscript = std::round((received[6 * index + i] - global_offset[i]) / block.spacing[i]);
+      if (subscript < scalar(0) || subscript >= scalar(global_shape[i]))
+        return;
+      cell[i] = std::size_t(subscript);
+    }
+    flow_map.data(cell) = vector3(received[6 * index + 3], received[6 * index + 4], received[6 * index + 5]);
+  });
+  return flow_map;
+#else
+  std::cout << "Flow map is not gathered since original positions are unavailable. Declare DPA_FTLE_SUPPORT and rebuild." << std::endl;
+  return regular_vector_field_3d();
+#endif
+}
+
+regular_vector_field_3d ftle_estimator::block_flow_map(
+  domain_partitioner*                        partitioner            ,
+  const regular_vector_field_3d&             original_vector_field  , 
+  const vector3&                             seed_stride            , 
+  const regular_vector_field_3d&             global_flow_map        )
+{
+#if DPA_FTLE_SUPPORT
+  const auto& multi_rank = partitioner->partitions().at(center).multi_rank;
+  const auto  block      = make_strided_block(partitioner, original_vector_field, seed_stride);
+
+  // Halo cells beyond the domain boundaries remain zero and unused.
+  auto flow_map = regular_vector_field_3d
+  (
+    padded_block_shape(block)     ,
+    block.offset - block.spacing  ,
+    original_vector_field.size    ,
+    block.spacing
+  );
+  const auto global_shape = global_flow_map.data.shape();
+  flow_map.apply([&] (const std::array<std::size_t, 3>& index, vector3& element)
+  {
+    std::array<std::size_t, 3> global_index;
+    for (auto i = 0; i < 3; ++i)
+    {
+      global_index[i] = block.shape[i] * multi_rank[i] + index[i] - 1; // Wraps below zero.
+      if (global_index[i] >= global_shape[i])
+        return;
+    }
+    element = global_flow_map.data(global_index);
+  });
+  return flow_map;
+#else
+  std::cout << "Flow map is not extracted since original positions are unavailable. Declare DPA_FTLE_SUPPORT and rebuild." << std::endl;
+  return regular_vector_field_3d();
+#endif
+}
+
+regular_vector_field_3d ftle_estimator::compose(
+  const regular_vector_field_3d&             flow_map               ,
+  const regular_vector_field_3d&             global_flow_map        )
+{
+  auto composed_flow_map = flow_map;
+  composed_flow_map.apply([&] (const std::array<std::size_t, 3>& index, vector3& element)
+  {
+    if (global_flow_map.contains(element))
+      element = global_flow_map.interpolate(element);
+  });
+  return composed_flow_map;
+}
+
+regular_scalar_field_3d ftle_estimator::estimate_block(
+  domain_partitioner*                        partitioner            ,
+  const regular_vector_field_3d&             original_vector_field  , 
+  const std::size_t                          iterations             , 
+  const vector3&                             seed_stride            , 
+  const scalar                               step_size              , 
+  const regular_vector_field_3d&             flow_map               )
+{
+#if DPA_FTLE_SUPPORT
+  const auto [lower_neighbor, upper_neighbor] = block_neighbors(partitioner);
+  return estimate_padded_block(partitioner, original_vector_field, seed_stride, flow_map, lower_neighbor, upper_neighbor, step_size * iterations);
+#else
+  std::cout << "FTLE is not estimated since original positions are unavailable. Declare DPA_FTLE_SUPPORT and rebuild." << std::endl;
+  return regular_scalar_field_3d();
+#endif
+}
+
+ftle_estimator::composition_error ftle_estimator::compare(
+  domain_partitioner*                        partitioner            ,
+  const regular_vector_field_3d&             lhs_flow_map           ,
+  const regular_vector_field_3d&             rhs_flow_map           )
+{
+  const auto& communicator = *partitioner->cartesian_communicator();
+  const auto  shape        = lhs_flow_map.data.shape();
+
+  // The maximum and the sum of squares of the distances over the cells of the block, excluding the halo.
+  using error_type = std::pair<scalar, double>;
+  const auto local_error = shape[0] > 2 && shape[1] > 2 && shape[2] > 2 ? tbb::parallel_reduce(tbb::blocked_range3d<std::size_t>(1, shape[0] - 1, 1, shape[1] - 1, 1, shape[2] - 1), error_type(0, 0), [&] (const tbb::blocked_range3d<std::size_t>& range, error_type error)
+  {
+    for (auto x = range.pages().begin(); x < range.pages().end(); ++x)
+    for (auto y = range.rows ().begin(); y < range.rows ().end(); ++y)
+    for (auto z = range.cols ().begin(); z < range.cols ().end(); ++z)
+    {
+      const auto index    = std::array<std::size_t, 3> {x, y, z};
+      const auto distance = (lhs_flow_map.data(index) - rhs_flow_map.data(index)).norm();
+      error.first   = std::max(error.first, distance);
+      error.second += double(distance) * double(distance);
+    }
+    return error;
+  }, [ ] (const error_type& lhs, const error_type& rhs)
+  {
+    return error_type(std::max(lhs.first, rhs.first), lhs.second + rhs.second);
+  }) : error_type(0, 0);
+  const auto local_count = shape[0] > 2 && shape[1] > 2 && shape[2] > 2 ? (shape[0] - 2) * (shape[1] - 2) * (shape[2] - 2) : std::size_t(0);
+
+  const auto maximum     = boost::mpi::all_reduce(communicator, local_error.first , boost::mpi::maximum<scalar>());
+  const auto squared_sum = boost::mpi::all_reduce(communicator, local_error.second, std::plus<double>());
+  const auto count       = boost::mpi::all_reduce(communicator, local_count       , std::plus<std::size_t>());
+  return composition_error {maximum, count > 0 ? scalar(std::sqrt(squared_sum / double(count))) : scalar(0)};
+}
+
+point_cloud             ftle_estimator::estimate_from_deformations(
+  const std::size_t                          seed_maximum_iterations, 
+  const scalar                               step_size              , 
+  const tbb::concurrent_vector<particle_3d>& local_particles        )
+{
+#if DPA_DEFORMATION_SUPPORT
+  point_cloud ftle {std::vector<vector3>(local_particles.size()), std::vector<scalar>(local_particles.size())};
+  tbb::parallel_for(std::size_t(0), local_particles.size(), std::size_t(1), [&] (const std::size_t index)
+  {
+    const auto& particle   = local_particles[index];
+    const auto& f          = particle.deformation;
+    const auto  iterations = seed_maximum_iterations - particle.remaining_iterations;
+    ftle.positions[index] = particle.original_position;
+    if (iterations == 0)
+      return;
+
+    // log(sqrt(lambda_max(F^T F))) / T.
+    const auto  c00        = f.col(0).dot(f.col(0)), c01 = f.col(0).dot(f.col(1)), c02 = f.col(0).dot(f.col(2));
+    const auto  c11        = f.col(1).dot(f.col(1)), c12 = f.col(1).dot(f.col(2)), c22 = f.col(2).dot(f.col(2));
+    ftle.values[index] = scalar(0.5) * std::log(largest_symmetric_eigenvalue(c00, c01, c02, c11, c12, c22)) / std::abs(step_size * iterations);
+  });
+  return ftle;
+#else
+  std::cout << "FTLE is not estimated since deformations are unavailable. Declare DPA_DEFORMATION_SUPPORT and rebuild." << std::endl;
+  return point_cloud();
+#endif
+}
 }
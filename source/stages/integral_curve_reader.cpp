@@ -0,0 +1,188 @@
+#include <dpa/stages/integral_curve_reader.hpp>
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include <hdf5.h>
+#include <tbb/tbb.h>
+
+#undef min
+#undef max
+
+namespace dpa
+{
+// Reads the range [offset, offset + count) of a 1D dataset.
+static void read_range(const hid_t dataset, const hid_t type, const hsize_t offset, const hsize_t count, void* data)
+{
+  if (count == 0)
+    return;
+
+  const auto space    = H5Dget_space    (dataset);
+  const auto memspace = H5Screate_simple(1, &count, nullptr);
+  H5Sselect_hyperslab(space, H5S_SELECT_SET, &offset, nullptr, &count, nullptr);
+  H5Dread            (dataset, type, memspace, space, H5P_DEFAULT, data);
+  H5Sclose           (memspace);
+  H5Sclose           (space   );
+}
+
+integral_curve_reader::integral_curve_reader(const std::string& filepath) : filepath_(filepath)
+{
+  const auto file = H5Fopen(filepath_.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+
+  H5G_info_t info;
+  H5Gget_info(file, &info);
+  for (hsize_t link_index = 0; link_index < info.nlinks; ++link_index)
+  {
+    std::string name(H5Lget_name_by_idx(file, ".", H5_INDEX_NAME, H5_ITER_INC, link_index, nullptr, 0, H5P_DEFAULT), '\0');
+    H5Lget_name_by_idx(file, ".", H5_INDEX_NAME, H5_ITER_INC, link_index, name.data(), name.size() + 1, H5P_DEFAULT);
+    if (name.rfind(chunk_bounds_prefix, 0) != 0)
+      continue;
+
+    auto& curve = curves_.emplace_back();
+    curve.index = std::stoull(name.substr(chunk_bounds_prefix.size()));
+
+    const auto bounds_dataset = H5Dopen(file, name.c_str(), H5P_DEFAULT);
+    const auto ranges_dataset = H5Dopen(file, (chunk_ranges_prefix + std::to_string(curve.index)).c_str(), H5P_DEFAULT);
+    const auto bounds_space   = H5Dget_space(bounds_dataset);
+    hsize_t bounds_count;
+    H5Sget_simple_extent_dims(bounds_space, &bounds_count, nullptr);
+
+    std::vector<float>         bounds(bounds_count);
+    std::vector<std::uint64_t> ranges(bounds_count / 6 * 4);
+    read_range(bounds_dataset, H5T_NATIVE_FLOAT , 0, bounds.size(), bounds.data());
+    read_range(ranges_dataset, H5T_NATIVE_UINT64, 0, ranges.size(), ranges.data());
+    for (std::size_t i = 0; i < bounds.size() / 6; ++i)
+      curve.chunks.push_back(spatial_chunk
+      {
+        vector3(bounds[6 * i    ], bounds[6 * i + 1], bounds[6 * i + 2]),
+        vector3(bounds[6 * i + 3], bounds[6 * i + 4], bounds[6 * i + 5]),
+        ranges[4 * i], ranges[4 * i + 1], ranges[4 * i + 2], ranges[4 * i + 3]
+      });
+
+    H5Sclose(bounds_space  );
+    H5Dclose(ranges_dataset);
+    H5Dclose(bounds_dataset);
+  }
+
+  H5Fclose(file);
+}
+
+const std::vector<integral_curve_reader::indexed_curve>& integral_curve_reader::curves() const
+{
+  return curves_;
+}
+
+integral_curves integral_curve_reader::read(const aabb3& box) const
+{
+  integral_curves integral_curves(curves_.size());
+
+  const auto file = H5Fopen(filepath_.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+  for (std::size_t curve_index = 0; curve_index < curves_.size(); ++curve_index)
+  {
+    auto& indexed_curve = curves_[curve_index];
+
+    // Runs of consecutive intersecting chunks, which are contiguous in the datasets.
+    std::vector<spatial_chunk> runs;
+    for (std::size_t i = 0; i < indexed_curve.chunks.size(); ++i)
+    {
+      const auto& chunk = indexed_curve.chunks[i];
+      if (!aabb3(chunk.minimum.transpose(), chunk.maximum.transpose()).intersects(box))
+        continue;
+
+      if (!runs.empty() && runs.back().vertex_end == chunk.vertex_begin && runs.back().index_end == chunk.index_begin)
+      {
+        runs.back().minimum    = runs.back().minimum.cwiseMin(chunk.minimum);
+        runs.back().maximum    = runs.back().maximum.cwiseMax(chunk.maximum);
+        runs.back().vertex_end = chunk.vertex_end;
+        runs.back().index_end  = chunk.index_end ;
+      }
+      else
+        runs.push_back(chunk);
+    }
+    if (runs.empty())
+      continue;
+
+    std::uint64_t vertex_count = 0;
+    std::uint64_t index_count  = 0;
+    for (auto& run : runs)
+    {
+      vertex_count += run.vertex_end - run.vertex_begin;
+      index_count  += run.index_end  - run.index_begin ;
+    }
+
+    const auto suffix           = std::to_string(indexed_curve.index);
+    const auto vertices_dataset = H5Dopen(file, ("vertices_" + suffix).c_str(), H5P_DEFAULT);
+    const auto colors_dataset   = H5Dopen(file, ("colors_"   + suffix).c_str(), H5P_DEFAULT);
+    const auto indices_dataset  = H5Dopen(file, ("indices_"  + suffix).c_str(), H5P_DEFAULT);
+    const auto colors_type      = H5Dget_type(colors_dataset );
+    const auto indices_type     = H5Dget_type(indices_dataset);
+    const auto colors_space     = H5Dget_space(colors_dataset);
+    const auto scalar_colors    = H5Tget_class(colors_type) == H5T_FLOAT;
+    hsize_t color_element_count;
+    H5Sget_simple_extent_dims(colors_space, &color_element_count, nullptr);
+    H5Sclose(colors_space);
+
+    // Colors are optional, i.e. the dataset may be empty.
+    hsize_t vertex_element_count;
+    const auto vertices_space   = H5Dget_space(vertices_dataset);
+    H5Sget_simple_extent_dims(vertices_space, &vertex_element_count, nullptr);
+    H5Sclose(vertices_space);
+    const auto read_colors      = color_element_count == (scalar_colors ? vertex_element_count / 3 : vertex_element_count);
+
+    auto& curve = integral_curves[curve_index];
+    curve.vertices = integral_curve::vertex_vector(allocator<vector3>(allocation_policy {true, false}));
+    curve.vertices.resize(vertex_count);
+    if (scalar_colors)
+      curve.colors  = std::vector<scalar>       (read_colors ? vertex_count : 0);
+    else
+      curve.colors  = std::vector<bvector3>     (read_colors ? vertex_count : 0);
+    if (H5Tget_size(indices_type) == sizeof(std::uint64_t))
+      curve.indices = std::vector<std::uint64_t>(index_count );
+    else
+      curve.indices = std::vector<std::uint32_t>(index_count );
+
+    std::uint64_t vertex_offset = 0;
+    std::uint64_t index_offset  = 0;
+    for (auto& run : runs)
+    {
+      const auto run_vertex_count = run.vertex_end - run.vertex_begin;
+      const auto run_index_count  = run.index_end  - run.index_begin ;
+
+      read_range(vertices_dataset, H5T_NATIVE_FLOAT, 3 * run.vertex_begin, 3 * run_vertex_count, curve.vertices.data()->data() + 3 * vertex_offset);
+      std::visit([&] (auto& cast_colors)
+      {
+        using color_type = typename std::decay_t<decltype(cast_colors)>::value_type;
+        if (!read_colors)
+          return;
+        if constexpr (std::is_same_v<color_type, scalar>)
+          read_range(colors_dataset, H5T_NATIVE_FLOAT,     run.vertex_begin,     run_vertex_count, cast_colors.data() + vertex_offset);
+        else
+          read_range(colors_dataset, H5T_NATIVE_UINT8, 3 * run.vertex_begin, 3 * run_vertex_count, cast_colors.data()->data() + 3 * vertex_offset);
+      }, curve.colors);
+      std::visit([&] (auto& cast_indices)
+      {
+        using index_type = typename std::decay_t<decltype(cast_indices)>::value_type;
+        read_range(indices_dataset, sizeof(index_type) == sizeof(std::uint64_t) ? H5T_NATIVE_UINT64 : H5T_NATIVE_UINT32, run.index_begin, run_index_count, cast_indices.data() + index_offset);
+        tbb::parallel_for(index_offset, index_offset + run_index_count, std::uint64_t(1), [&] (const std::uint64_t i)
+        {
+          cast_indices[i] = static_cast<index_type>(cast_indices[i] - run.vertex_begin + vertex_offset);
+        });
+      }, curve.indices);
+
+      vertex_offset += run_vertex_count;
+      index_offset  += run_index_count ;
+    }
+
+    H5Tclose(indices_type    );
+    H5Tclose(colors_type     );
+    H5Dclose(indices_dataset );
+    H5Dclose(colors_dataset  );
+    H5Dclose(vertices_dataset);
+  }
+  H5Fclose(file);
+
+  return integral_curves;
+}
+}
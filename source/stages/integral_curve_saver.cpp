@@ -1,7 +1,13 @@
 #include <dpa/stages/integral_curve_saver.hpp>
 
+#include <algorithm>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+#include <utility>
 #include <variant>
 
 #include <boost/algorithm/string/replace.hpp>
@@ -9,6 +15,7 @@
 #include <hdf5.h>
 #include <tbb/tbb.h>
 
+#include <dpa/utility/hdf5_compression.hpp>
 #include <dpa/utility/xdmf.hpp>
 
 #undef min
@@ -16,11 +23,24 @@
 
 namespace dpa
 {
-integral_curve_saver::integral_curve_saver (domain_partitioner* partitioner, const std::string& filepath) 
-: partitioner_(partitioner)
-, filepath_   (std::filesystem::path(filepath).replace_extension(".rank_" + std::to_string(partitioner_->cartesian_communicator()->rank()) + ".h5").string())
+// Chunk size of all chunked datasets in elements.
+constexpr hsize_t chunk_size = 1 << 20;
+
+integral_curve_saver::integral_curve_saver (domain_partitioner* partitioner, const std::string& filepath, const std::string& compression, const std::optional<size>& mantissa_bits, const bool spatial_index) 
+: partitioner_    (partitioner)
+, filepath_       (std::filesystem::path(filepath).replace_extension(".rank_" + std::to_string(partitioner_->cartesian_communicator()->rank()) + ".h5").string())
+, shared_filepath_(std::filesystem::path(filepath).replace_extension(".h5").string())
+, mantissa_bits_  (mantissa_bits)
+, spatial_index_  (spatial_index)
 {
+  if      (compression == "deflate") compression_ = available_compression(compression::deflate);
+  else if (compression == "lz4"    ) compression_ = available_compression(compression::lz4    );
+  else                               compression_ = compression::none;
+}
 
+const compression_statistics& integral_curve_saver::statistics() const
+{
+  return statistics_;
 }
 
 void integral_curve_saver::save(const integral_curves& integral_curves)
@@ -30,38 +50,46 @@ void integral_curve_saver::save(const integral_curves& integral_curves)
   const auto file = H5Fcreate(filepath_.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
   for (std::size_t curve_index = 0; curve_index < integral_curves.size(); ++curve_index)
   {
-    auto& curve    = integral_curves[curve_index];
-    auto& vertices = curve.vertices;
-    auto& colors   = curve.colors  ;
-    auto& indices  = curve.indices ;
+    integral_curve             sorted_curve;
+    std::vector<spatial_chunk> chunks      ;
+    if (spatial_index_)
+      sorted_curve = spatially_sorted(integral_curves[curve_index], chunks);
+
+    auto& curve        = spatial_index_ ? sorted_curve : integral_curves[curve_index];
+    auto  vertex_count = curve.vertex_count();
+    auto& colors       = curve.colors        ;
+    auto& indices      = curve.indices       ;
 
-    if (vertices.empty())
+    if (vertex_count == 0)
       continue;
     
     const auto use_scalar_colors    = std::holds_alternative<std::vector<scalar>>       (colors );
     const auto use_64_bit_indices   = std::holds_alternative<std::vector<std::uint64_t>>(indices);
 
-    const auto vertex_element_count = hsize_t(3 * vertices.size());
-    const auto color_element_count  = hsize_t(use_scalar_colors  ? vertices.size() : 3 * vertices.size());
+    const auto vertex_element_count = hsize_t(3 * vertex_count);
+    const auto color_element_count  = hsize_t(use_scalar_colors  ? vertex_count : 3 * vertex_count);
     const auto index_count          = hsize_t(use_64_bit_indices ? std::get<std::vector<std::uint64_t>>(indices).size() : std::get<std::vector<std::uint32_t>>(indices).size());
     const auto vertices_name        = "vertices_" + std::to_string(curve_index);
     const auto colors_name          = "colors_"   + std::to_string(curve_index);
     const auto indices_name         = "indices_"  + std::to_string(curve_index);
-    const auto vertices_space       = H5Screate_simple(1, &vertex_element_count, nullptr);
-    const auto colors_space         = H5Screate_simple(1, &color_element_count , nullptr);
-    const auto indices_space        = H5Screate_simple(1, &index_count         , nullptr);
-    const auto vertices_dataset     = H5Dcreate2(file, vertices_name.c_str(), H5T_NATIVE_FLOAT                                          , vertices_space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-    const auto colors_dataset       = H5Dcreate2(file, colors_name  .c_str(), use_scalar_colors  ? H5T_NATIVE_FLOAT  : H5T_NATIVE_UINT8 , colors_space  , H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-    const auto indices_dataset      = H5Dcreate2(file, indices_name .c_str(), use_64_bit_indices ? H5T_NATIVE_UINT64 : H5T_NATIVE_UINT32, indices_space , H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-    H5Dwrite(vertices_dataset, H5T_NATIVE_FLOAT                                          , vertices_space, vertices_space, H5P_DEFAULT, vertices.data()->data());
-    H5Dwrite(colors_dataset  , use_scalar_colors  ? H5T_NATIVE_FLOAT  : H5T_NATIVE_UINT8 , colors_space  , colors_space  , H5P_DEFAULT, use_scalar_colors  ? reinterpret_cast<const void*>(std::get<std::vector<scalar>>       (colors ).data()) : std::get<std::vector<bvector3>>     (colors ).data()->data());
-    H5Dwrite(indices_dataset , use_64_bit_indices ? H5T_NATIVE_UINT64 : H5T_NATIVE_UINT32, indices_space , indices_space , H5P_DEFAULT, use_64_bit_indices ? reinterpret_cast<const void*>(std::get<std::vector<std::uint64_t>>(indices).data()) : std::get<std::vector<std::uint32_t>>(indices).data());
-    H5Sclose(vertices_space  );
-    H5Sclose(colors_space    );
-    H5Sclose(indices_space   );
-    H5Dclose(vertices_dataset);
-    H5Dclose(colors_dataset  );
-    H5Dclose(indices_dataset );
+    std::vector<float> vertex_buffer;
+    write_compressed(file, vertices_name, H5T_NATIVE_FLOAT                                          , sizeof(float)                                                   , vertex_data(curve, vertex_buffer), vertex_element_count, compression_, chunk_size, statistics_);
+    write_compressed(file, colors_name  , use_scalar_colors  ? H5T_NATIVE_FLOAT  : H5T_NATIVE_UINT8 , use_scalar_colors  ? sizeof(float)         : sizeof(std::uint8_t) , use_scalar_colors  ? reinterpret_cast<const void*>(std::get<std::vector<scalar>>       (colors ).data()) : std::get<std::vector<bvector3>>     (colors ).data()->data(), color_element_count, compression_, chunk_size, statistics_);
+    write_compressed(file, indices_name , use_64_bit_indices ? H5T_NATIVE_UINT64 : H5T_NATIVE_UINT32, use_64_bit_indices ? sizeof(std::uint64_t) : sizeof(std::uint32_t), use_64_bit_indices ? reinterpret_cast<const void*>(std::get<std::vector<std::uint64_t>>(indices).data()) : std::get<std::vector<std::uint32_t>>(indices).data(), index_count, compression_, chunk_size, statistics_);
+
+    if (spatial_index_)
+    {
+      // Small enough to be read at once, hence neither chunked nor compressed.
+      std::vector<float>         bounds;
+      std::vector<std::uint64_t> ranges;
+      for (auto& chunk : chunks)
+      {
+        bounds.insert(bounds.end(), {chunk.minimum[0], chunk.minimum[1], chunk.minimum[2], chunk.maximum[0], chunk.maximum[1], chunk.maximum[2]});
+        ranges.insert(ranges.end(), {chunk.vertex_begin, chunk.vertex_end, chunk.index_begin, chunk.index_end});
+      }
+      write_compressed(file, chunk_bounds_prefix + std::to_string(curve_index), H5T_NATIVE_FLOAT , sizeof(float)        , bounds.data(), bounds.size(), compression::none, chunk_size, statistics_);
+      write_compressed(file, chunk_ranges_prefix + std::to_string(curve_index), H5T_NATIVE_UINT64, sizeof(std::uint64_t), ranges.data(), ranges.size(), compression::none, chunk_size, statistics_);
+    }
     
     auto& xdmf = xdmf_bodies.emplace_back(xdmf_body_geometry);
     boost::replace_all(xdmf, "$FILEPATH"             , std::filesystem::path(filepath_).filename().string());
@@ -86,4 +114,434 @@ void integral_curve_saver::save(const integral_curves& integral_curves)
   std::ofstream stream(filepath_ + ".xdmf");
   stream << xdmf_header << std::accumulate(xdmf_bodies.begin(), xdmf_bodies.end(), std::string("")) << xdmf_footer;
 }
-}
\ No newline at end of file
+
+void integral_curve_saver::save_shared(const integral_curves& integral_curves)
+{
+  const auto& communicator = *partitioner_->cartesian_communicator();
+
+  std::size_t local_vertex_count  = 0;
+  std::size_t local_index_count   = 0;
+  bool        local_vector_colors = false;
+  for (auto& curve : integral_curves)
+  {
+    local_vertex_count += curve.vertex_count();
+    local_index_count  += std::visit([ ] (const auto& indices) { return indices.size(); }, curve.indices);
+    if (curve.vertex_count() > 0 && std::holds_alternative<std::vector<bvector3>>(curve.colors))
+      local_vector_colors = true;
+  }
+
+  // The ranks agree on the types, sizes and number of (collective) writes, which is the maximum number of rounds.
+  const auto vertex_count       = boost::mpi::all_reduce(communicator, local_vertex_count   , std::plus<std::size_t>());
+  const auto index_count        = boost::mpi::all_reduce(communicator, local_index_count    , std::plus<std::size_t>());
+  const auto curve_count        = boost::mpi::all_reduce(communicator, integral_curves.size(), boost::mpi::maximum<std::size_t>());
+  const auto use_scalar_colors  = !boost::mpi::all_reduce(communicator, local_vector_colors , std::logical_or<bool>());
+  const auto use_64_bit_indices = vertex_count > std::numeric_limits<std::uint32_t>::max();
+  auto       vertex_offset      = boost::mpi::scan      (communicator, local_vertex_count   , std::plus<std::size_t>()) - local_vertex_count;
+  auto       index_offset       = boost::mpi::scan      (communicator, local_index_count    , std::plus<std::size_t>()) - local_index_count ;
+
+  if (vertex_count == 0)
+    return;
+
+  const auto start                = tbb::tick_count::now();
+  const auto vertex_element_count = hsize_t(3 * vertex_count);
+  const auto color_element_count  = hsize_t(use_scalar_colors ? vertex_count : 3 * vertex_count);
+  const auto index_element_count  = hsize_t(index_count);
+  const auto color_type           = use_scalar_colors  ? H5T_NATIVE_FLOAT  : H5T_NATIVE_UINT8 ;
+  const auto index_type           = use_64_bit_indices ? H5T_NATIVE_UINT64 : H5T_NATIVE_UINT32;
+
+  const auto file_property        = H5Pcreate(H5P_FILE_ACCESS);
+  H5Pset_fapl_mpio(file_property, communicator, MPI_INFO_NULL);
+  const auto file                 = H5Fcreate       (shared_filepath_.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, file_property);
+  const auto vertices_space       = H5Screate_simple(1, &vertex_element_count, nullptr);
+  const auto colors_space         = H5Screate_simple(1, &color_element_count , nullptr);
+  const auto indices_space        = H5Screate_simple(1, &index_element_count , nullptr);
+  // Filtered datasets are compressed through the parallel compression of HDF5, which requires collective writes.
+  const auto create_property      = [&] (const hsize_t element_count)
+  {
+    const auto property = H5Pcreate(H5P_DATASET_CREATE);
+    if (compression_ != compression::none && element_count > 0)
+    {
+      const auto chunk = std::min(chunk_size, element_count);
+      H5Pset_chunk           (property, 1, &chunk);
+      set_compression_filters(property, compression_);
+    }
+    return property;
+  };
+  const auto vertices_property    = create_property (vertex_element_count);
+  const auto colors_property      = create_property (color_element_count );
+  const auto indices_property     = create_property (index_element_count );
+  const auto vertices_dataset     = H5Dcreate2      (file, "vertices", H5T_NATIVE_FLOAT, vertices_space, H5P_DEFAULT, vertices_property, H5P_DEFAULT);
+  const auto colors_dataset       = H5Dcreate2      (file, "colors"  , color_type      , colors_space  , H5P_DEFAULT, colors_property  , H5P_DEFAULT);
+  const auto indices_dataset      = H5Dcreate2      (file, "indices" , index_type      , indices_space , H5P_DEFAULT, indices_property , H5P_DEFAULT);
+  const auto transfer_property    = H5Pcreate       (H5P_DATASET_XFER);
+  H5Pset_dxpl_mpio(transfer_property, H5FD_MPIO_COLLECTIVE);
+
+  // Ranks without (a round of) curves participate with an empty selection.
+  const auto write = [&] (const hid_t dataset, const hid_t type, const hsize_t offset, const hsize_t count, const void* data)
+  {
+    const auto space    = H5Dget_space    (dataset);
+    const auto memspace = H5Screate_simple(1, &count, nullptr);
+    if (count > 0)
+      H5Sselect_hyperslab(space, H5S_SELECT_SET, &offset, nullptr, &count, nullptr);
+    else
+    {
+      H5Sselect_none(space   );
+      H5Sselect_none(memspace);
+    }
+    H5Dwrite(dataset, type, memspace, space, transfer_property, data);
+    H5Sclose(memspace);
+    H5Sclose(space   );
+  };
+  const auto rebase_and_write = [&] (const auto& indices, auto rebased_indices)
+  {
+    rebased_indices.resize(indices.size());
+    tbb::parallel_for(std::size_t(0), indices.size(), std::size_t(1), [&] (const std::size_t index)
+    {
+      rebased_indices[index] = indices[index] + vertex_offset;
+    });
+    write(indices_dataset, index_type, index_offset, rebased_indices.size(), rebased_indices.data());
+  };
+
+  for (std::size_t curve_index = 0; curve_index < curve_count; ++curve_index)
+  {
+    if (curve_index >= integral_curves.size() || integral_curves[curve_index].vertex_count() == 0)
+    {
+      write(vertices_dataset, H5T_NATIVE_FLOAT, 0, 0, nullptr);
+      write(colors_dataset  , color_type      , 0, 0, nullptr);
+      write(indices_dataset , index_type      , 0, 0, nullptr);
+      continue;
+    }
+
+    // Not spatially sorted: the dataset sizes and rank offsets above are of the curves as given.
+    auto& curve        = integral_curves[curve_index];
+    auto  vertex_count = curve.vertex_count();
+    auto& colors       = curve.colors        ;
+    auto& indices      = curve.indices       ;
+
+    std::vector<float> vertex_buffer;
+    write(vertices_dataset, H5T_NATIVE_FLOAT, 3 * vertex_offset, 3 * vertex_count, vertex_data(curve, vertex_buffer));
+    write(colors_dataset  , color_type      , use_scalar_colors ? vertex_offset : 3 * vertex_offset, use_scalar_colors ? vertex_count : 3 * vertex_count, use_scalar_colors ? reinterpret_cast<const void*>(std::get<std::vector<scalar>>(colors).data()) : std::get<std::vector<bvector3>>(colors).data()->data());
+    std::visit([&] (const auto& cast_indices)
+    {
+      if (use_64_bit_indices)
+        rebase_and_write(cast_indices, std::vector<std::uint64_t>());
+      else
+        rebase_and_write(cast_indices, std::vector<std::uint32_t>());
+      index_offset += cast_indices.size();
+    }, indices);
+    vertex_offset += vertex_count;
+  }
+
+  statistics_.uncompressed_bytes += vertex_element_count * sizeof(float) + color_element_count * (use_scalar_colors ? sizeof(float) : sizeof(std::uint8_t)) + index_element_count * (use_64_bit_indices ? sizeof(std::uint64_t) : sizeof(std::uint32_t));
+  statistics_.compressed_bytes   += H5Dget_storage_size(vertices_dataset) + H5Dget_storage_size(colors_dataset) + H5Dget_storage_size(indices_dataset);
+  statistics_.seconds            += (tbb::tick_count::now() - start).seconds();
+
+  H5Pclose(transfer_property);
+  H5Pclose(vertices_property);
+  H5Pclose(colors_property  );
+  H5Pclose(indices_property );
+  H5Sclose(vertices_space   );
+  H5Sclose(colors_space     );
+  H5Sclose(indices_space    );
+  H5Dclose(vertices_dataset );
+  H5Dclose(colors_dataset   );
+  H5Dclose(indices_dataset  );
+  H5Fclose(file             );
+  H5Pclose(file_property    );
+
+  if (communicator.rank() != 0)
+    return;
+
+  auto xdmf = xdmf_body_geometry;
+  boost::replace_all(xdmf, "$FILEPATH"             , std::filesystem::path(shared_filepath_).filename().string());
+  boost::replace_all(xdmf, "$GRID_NAME"            , "grid");   
+  boost::replace_all(xdmf, "$VERTICES_DATASET_NAME", "vertices");
+  boost::replace_all(xdmf, "$VERTEX_ARRAY_SIZE"    , std::to_string(vertex_element_count));
+  boost::replace_all(xdmf, "$COLORS_DATASET_NAME"  , "colors"  );
+  boost::replace_all(xdmf, "$COLOR_ARRAY_SIZE"     , std::to_string(color_element_count));
+  boost::replace_all(xdmf, "$COLOR_ATTRIBUTE_TYPE" , use_scalar_colors ? "Scalar" : "Vector");
+  boost::replace_all(xdmf, "$COLOR_ARRAY_TYPE"     , use_scalar_colors ? "Float"  : "UChar" );
+  boost::replace_all(xdmf, "$COLOR_PRECISION"      , use_scalar_colors ? "4"      : "1"     );
+  boost::replace_all(xdmf, "$INDICES_DATASET_NAME" , "indices" );
+  boost::replace_all(xdmf, "$INDEX_ARRAY_SIZE"     , std::to_string(index_element_count));
+  boost::replace_all(xdmf, "$INDEX_PRECISION"      , use_64_bit_indices ? "8" : "4");
+  boost::replace_all(xdmf, "$POLYLINE_COUNT"       , std::to_string(index_element_count / 2));
+
+  std::ofstream stream(shared_filepath_ + ".xdmf");
+  stream << xdmf_header << xdmf << xdmf_footer;
+}
+
+void integral_curve_saver::save_async(integral_curves&& integral_curves)
+{
+  if (pending_.valid())
+    pending_.get();
+
+  // HDF5 is only called from this thread until the write completes.
+  pending_ = std::async(std::launch::async, [this, integral_curves = std::move(integral_curves)] () 
+  {
+    append(integral_curves);
+  });
+}
+void integral_curve_saver::finalize  ()
+{
+  if (pending_.valid())
+    pending_.get();
+
+  if (file_ < 0)
+    return;
+
+  hsize_t vertex_dataset_size, color_dataset_size, index_dataset_size;
+  {
+    const auto vertices_space = H5Dget_space(vertices_dataset_);
+    const auto colors_space   = H5Dget_space(colors_dataset_  );
+    const auto indices_space  = H5Dget_space(indices_dataset_ );
+    H5Sget_simple_extent_dims(vertices_space, &vertex_dataset_size, nullptr);
+    H5Sget_simple_extent_dims(colors_space  , &color_dataset_size , nullptr);
+    H5Sget_simple_extent_dims(indices_space , &index_dataset_size , nullptr);
+    H5Sclose(vertices_space);
+    H5Sclose(colors_space  );
+    H5Sclose(indices_space );
+  }
+
+  std::vector<std::string> xdmf_bodies;
+  for (auto& range : ranges_)
+  {
+    auto& xdmf = xdmf_bodies.emplace_back(xdmf_body_geometry_hyperslab);
+    boost::replace_all(xdmf, "$FILEPATH"             , std::filesystem::path(filepath_).filename().string());
+    boost::replace_all(xdmf, "$GRID_NAME"            , "grid_" + std::to_string(range.index));   
+    boost::replace_all(xdmf, "$VERTICES_DATASET_NAME", "vertices");
+    boost::replace_all(xdmf, "$VERTEX_ARRAY_OFFSET"  , std::to_string(range.vertex_offset));
+    boost::replace_all(xdmf, "$VERTEX_ARRAY_SIZE"    , std::to_string(range.vertex_count ));
+    boost::replace_all(xdmf, "$VERTEX_DATASET_SIZE"  , std::to_string(vertex_dataset_size));
+    boost::replace_all(xdmf, "$COLORS_DATASET_NAME"  , "colors"  );
+    boost::replace_all(xdmf, "$COLOR_ARRAY_OFFSET"   , std::to_string(range.color_offset));
+    boost::replace_all(xdmf, "$COLOR_ARRAY_SIZE"     , std::to_string(range.color_count ));
+    boost::replace_all(xdmf, "$COLOR_DATASET_SIZE"   , std::to_string(color_dataset_size));
+    boost::replace_all(xdmf, "$COLOR_ATTRIBUTE_TYPE" , use_scalar_colors_ ? "Scalar" : "Vector");
+    boost::replace_all(xdmf, "$COLOR_ARRAY_TYPE"     , use_scalar_colors_ ? "Float"  : "UChar" );
+    boost::replace_all(xdmf, "$COLOR_PRECISION"      , use_scalar_colors_ ? "4"      : "1"     );
+    boost::replace_all(xdmf, "$INDICES_DATASET_NAME" , "indices" );
+    boost::replace_all(xdmf, "$INDEX_ARRAY_OFFSET"   , std::to_string(range.index_offset));
+    boost::replace_all(xdmf, "$INDEX_ARRAY_SIZE"     , std::to_string(range.index_count ));
+    boost::replace_all(xdmf, "$INDEX_DATASET_SIZE"   , std::to_string(index_dataset_size));
+    boost::replace_all(xdmf, "$INDEX_PRECISION"      , use_64_bit_indices_ ? "8" : "4");
+    boost::replace_all(xdmf, "$POLYLINE_COUNT"       , std::to_string(range.index_count / 2));
+  }
+
+  statistics_.compressed_bytes = H5Dget_storage_size(vertices_dataset_) + H5Dget_storage_size(colors_dataset_) + H5Dget_storage_size(indices_dataset_);
+
+  H5Dclose(vertices_dataset_);
+  H5Dclose(colors_dataset_  );
+  H5Dclose(indices_dataset_ );
+  H5Fclose(file_            );
+  file_ = vertices_dataset_ = colors_dataset_ = indices_dataset_ = -1;
+
+  std::ofstream stream(filepath_ + ".xdmf");
+  stream << xdmf_header << std::accumulate(xdmf_bodies.begin(), xdmf_bodies.end(), std::string("")) << xdmf_footer;
+}
+
+void integral_curve_saver::append    (const integral_curves& integral_curves)
+{
+  const auto start          = tbb::tick_count::now();
+  const auto create_dataset = [&] (const std::string& name, const hid_t type)
+  {
+    const hsize_t size         = 0;
+    const hsize_t maximum_size = H5S_UNLIMITED;
+    const auto    space        = H5Screate_simple(1, &size, &maximum_size);
+    const auto    property     = H5Pcreate       (H5P_DATASET_CREATE);
+    H5Pset_chunk           (property, 1, &chunk_size);
+    set_compression_filters(property, compression_);
+    const auto    dataset      = H5Dcreate2      (file_, name.c_str(), type, space, H5P_DEFAULT, property, H5P_DEFAULT);
+    H5Pclose(property);
+    H5Sclose(space   );
+    return dataset;
+  };
+  const auto append_dataset = [&] (const hid_t dataset, const hid_t type, const void* data, const hsize_t count)
+  {
+    hsize_t offset;
+    auto    space    = H5Dget_space(dataset);
+    H5Sget_simple_extent_dims(space, &offset, nullptr);
+    H5Sclose(space);
+
+    const auto size     = offset + count;
+    H5Dset_extent(dataset, &size);
+    space               = H5Dget_space    (dataset);
+    const auto memspace = H5Screate_simple(1, &count, nullptr);
+    H5Sselect_hyperslab(space, H5S_SELECT_SET, &offset, nullptr, &count, nullptr);
+    H5Dwrite           (dataset, type, memspace, space, H5P_DEFAULT, data);
+    H5Sclose           (memspace);
+    H5Sclose           (space   );
+    return offset;
+  };
+
+  for (auto& curve : integral_curves)
+  {
+    const auto curve_index = curve_count_++;
+
+    auto  vertex_count = curve.vertex_count();
+    auto& colors       = curve.colors        ;
+    auto& indices      = curve.indices       ;
+
+    if (vertex_count == 0)
+      continue;
+
+    // The types are determined by the first non-empty curve.
+    if (file_ < 0)
+    {
+      use_scalar_colors_  = std::holds_alternative<std::vector<scalar>>       (colors );
+      use_64_bit_indices_ = std::holds_alternative<std::vector<std::uint64_t>>(indices);
+      file_               = H5Fcreate     (filepath_.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+      vertices_dataset_   = create_dataset("vertices", H5T_NATIVE_FLOAT);
+      colors_dataset_     = create_dataset("colors"  , use_scalar_colors_  ? H5T_NATIVE_FLOAT  : H5T_NATIVE_UINT8 );
+      indices_dataset_    = create_dataset("indices" , use_64_bit_indices_ ? H5T_NATIVE_UINT64 : H5T_NATIVE_UINT32);
+    }
+
+    range range {curve_index};
+    range.vertex_count  = hsize_t(3 * vertex_count);
+    range.color_count   = hsize_t(use_scalar_colors_  ? vertex_count : 3 * vertex_count);
+    range.index_count   = hsize_t(use_64_bit_indices_ ? std::get<std::vector<std::uint64_t>>(indices).size() : std::get<std::vector<std::uint32_t>>(indices).size());
+    std::vector<float> vertex_buffer;
+    range.vertex_offset = append_dataset(vertices_dataset_, H5T_NATIVE_FLOAT                                           , vertex_data(curve, vertex_buffer), range.vertex_count);
+    range.color_offset  = append_dataset(colors_dataset_  , use_scalar_colors_  ? H5T_NATIVE_FLOAT  : H5T_NATIVE_UINT8 , use_scalar_colors_  ? reinterpret_cast<const void*>(std::get<std::vector<scalar>>       (colors ).data()) : std::get<std::vector<bvector3>>     (colors ).data()->data(), range.color_count);
+    range.index_offset  = append_dataset(indices_dataset_ , use_64_bit_indices_ ? H5T_NATIVE_UINT64 : H5T_NATIVE_UINT32, use_64_bit_indices_ ? reinterpret_cast<const void*>(std::get<std::vector<std::uint64_t>>(indices).data()) : std::get<std::vector<std::uint32_t>>(indices).data(), range.index_count);
+    ranges_.push_back(range);
+
+    statistics_.uncompressed_bytes += range.vertex_count * sizeof(float) + range.color_count * (use_scalar_colors_ ? sizeof(float) : sizeof(std::uint8_t)) + range.index_count * (use_64_bit_indices_ ? sizeof(std::uint64_t) : sizeof(std::uint32_t));
+  }
+
+  statistics_.seconds += (tbb::tick_count::now() - start).seconds();
+}
+
+const float* integral_curve_saver::vertex_data(const integral_curve& curve, std::vector<float>& buffer) const
+{
+  if (!curve.quantized() && !mantissa_bits_)
+    return curve.vertices.data()->data();
+
+  integral_curve::vertex_vector decoded_vertices;
+  const auto& vertices = curve.decoded_vertices(decoded_vertices);
+  buffer.assign(vertices.data()->data(), vertices.data()->data() + 3 * vertices.size());
+  if (mantissa_bits_)
+    round_mantissa(buffer.data(), buffer.size(), *mantissa_bits_);
+  return buffer.data();
+}
+
+integral_curve integral_curve_saver::spatially_sorted(const integral_curve& curve, std::vector<spatial_chunk>& chunks) const
+{
+  integral_curve::vertex_vector decoded_vertices;
+  const auto& vertices = curve.decoded_vertices(decoded_vertices);
+
+  // Polylines end with a terminal vertex. Their offsets are known if generated by the particle_advector or curve_stitcher.
+  auto polyline_offsets = curve.polyline_offsets;
+  if (polyline_offsets.empty())
+  {
+    polyline_offsets.push_back(0);
+    for (std::size_t i = 0; i < vertices.size(); ++i)
+      if (vertices[i] == terminal_value<vector3>())
+        polyline_offsets.push_back(i + 1);
+    if (polyline_offsets.back() != vertices.size())
+      polyline_offsets.push_back(vertices.size());
+  }
+  const auto polyline_count = polyline_offsets.size() - 1;
+
+  using bounds_type = std::pair<vector3, vector3>;
+  const auto empty_bounds = bounds_type(vector3::Constant(std::numeric_limits<scalar>::max()), vector3::Constant(std::numeric_limits<scalar>::lowest()));
+  const auto merge        = [ ] (const bounds_type& lhs, const bounds_type& rhs)
+  {
+    return bounds_type(lhs.first.cwiseMin(rhs.first), lhs.second.cwiseMax(rhs.second));
+  };
+
+  std::vector<bounds_type> polyline_bounds(polyline_count, empty_bounds);
+  tbb::parallel_for(std::size_t(0), polyline_count, std::size_t(1), [&] (const std::size_t i)
+  {
+    for (auto j = polyline_offsets[i]; j < polyline_offsets[i + 1]; ++j)
+      if (vertices[j] != terminal_value<vector3>())
+        polyline_bounds[i] = merge(polyline_bounds[i], bounds_type(vertices[j], vertices[j]));
+  });
+  const auto bounds = tbb::parallel_reduce(tbb::blocked_range<std::size_t>(0, polyline_count), empty_bounds,
+    [&] (const tbb::blocked_range<std::size_t>& range, bounds_type bounds)
+    {
+      for (auto i = range.begin(); i < range.end(); ++i)
+        bounds = merge(bounds, polyline_bounds[i]);
+      return bounds;
+    }, merge);
+
+  std::vector<std::pair<std::uint64_t, std::size_t>> order(polyline_count);
+  tbb::parallel_for(std::size_t(0), polyline_count, std::size_t(1), [&] (const std::size_t i)
+  {
+    order[i] = {morton_code(scalar(0.5) * (polyline_bounds[i].first + polyline_bounds[i].second), bounds.first, bounds.second), i};
+  });
+  tbb::parallel_sort(order.begin(), order.end());
+
+  // Every vertex but the first one and the terminal one of a polyline ends a line segment.
+  const auto vertex_count  = [&] (const std::size_t i) { return polyline_offsets[i + 1] - polyline_offsets[i]; };
+  const auto segment_count = [&] (const std::size_t i)
+  {
+    const auto count = vertex_count(i) - (vertices[polyline_offsets[i + 1] - 1] == terminal_value<vector3>() ? 1 : 0);
+    return std::max(count, std::size_t(1)) - 1;
+  };
+  std::vector<std::size_t> vertex_offsets(polyline_count + 1, 0);
+  std::vector<std::size_t> index_offsets (polyline_count + 1, 0);
+  for (std::size_t i = 0; i < polyline_count; ++i)
+  {
+    vertex_offsets[i + 1] = vertex_offsets[i] + vertex_count (order[i].second);
+    index_offsets [i + 1] = index_offsets [i] + segment_count(order[i].second) * 2;
+  }
+
+  integral_curve sorted;
+  sorted.vertices = integral_curve::vertex_vector(allocator<vector3>(allocation_policy {true, false}));
+  sorted.vertices.resize(vertices.size());
+  std::visit([&] (const auto& cast_colors)
+  {
+    using colors_type = std::decay_t<decltype(cast_colors)>;
+    sorted.colors = colors_type(cast_colors.size() == vertices.size() ? vertices.size() : 0);
+  }, curve.colors);
+  std::visit([&] (const auto& cast_indices)
+  {
+    using indices_type = std::decay_t<decltype(cast_indices)>;
+    sorted.indices = indices_type(index_offsets.back());
+  }, curve.indices);
+  sorted.polyline_ids     .resize(curve.polyline_ids     .size() == polyline_count ? polyline_count : 0);
+  sorted.polyline_segments.resize(curve.polyline_segments.size() == polyline_count ? polyline_count : 0);
+  sorted.polyline_offsets = vertex_offsets;
+
+  tbb::parallel_for(std::size_t(0), polyline_count, std::size_t(1), [&] (const std::size_t i)
+  {
+    const auto source = polyline_offsets[order[i].second];
+    const auto target = vertex_offsets  [i];
+    const auto count  = vertex_count    (order[i].second);
+
+    std::copy_n(vertices.begin() + source, count, sorted.vertices.begin() + target);
+    std::visit([&] (auto& cast_colors)
+    {
+      using colors_type = std::decay_t<decltype(cast_colors)>;
+      if (!cast_colors.empty())
+        std::copy_n(std::get<colors_type>(curve.colors).begin() + source, count, cast_colors.begin() + target);
+    }, sorted.colors);
+    std::visit([&] (auto& cast_indices)
+    {
+      auto index_offset = index_offsets[i];
+      for (std::size_t j = 1; j <= segment_count(order[i].second); ++j)
+      {
+        cast_indices[index_offset++] = target + j - 1;
+        cast_indices[index_offset++] = target + j;
+      }
+    }, sorted.indices);
+    if (!sorted.polyline_ids     .empty()) sorted.polyline_ids     [i] = curve.polyline_ids     [order[i].second];
+    if (!sorted.polyline_segments.empty()) sorted.polyline_segments[i] = curve.polyline_segments[order[i].second];
+  });
+
+  for (std::size_t i = 0; i < polyline_count; ++i)
+  {
+    if (chunks.empty() || chunks.back().vertex_end - chunks.back().vertex_begin >= spatial_chunk_vertices)
+      chunks.push_back(spatial_chunk {empty_bounds.first, empty_bounds.second, vertex_offsets[i], vertex_offsets[i], index_offsets[i], index_offsets[i]});
+
+    auto& chunk        = chunks.back();
+    chunk.minimum      = chunk.minimum.cwiseMin(polyline_bounds[order[i].second].first );
+    chunk.maximum      = chunk.maximum.cwiseMax(polyline_bounds[order[i].second].second);
+    chunk.vertex_end   = vertex_offsets[i + 1];
+    chunk.index_end    = index_offsets [i + 1];
+  }
+
+  return sorted;
+}
+}
@@ -1,7 +1,12 @@
 #include <dpa/stages/particle_advector.hpp>
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <functional>
+#include <iostream>
 #include <optional>
+#include <variant>
 
 #include <boost/serialization/vector.hpp>
 #include <boost/mpi.hpp>
@@ -14,13 +19,131 @@
 
 namespace dpa
 {
-particle_advector::particle_advector(domain_partitioner* partitioner, const size particles_per_round, const std::string& load_balancer, const std::string& integrator, const scalar step_size, const bool gather_particles, const bool record)
-: partitioner_        (partitioner)
-, particles_per_round_(particles_per_round)
-, step_size_          (step_size)
-, gather_particles_   (gather_particles)
-, record_             (record)
+// Positions are held for at most this many steps by the simplification, which bounds its cost per step.
+constexpr std::size_t simplification_window = 64;
+
+// Distance of a point to the line segment between begin and end.
+static scalar chord_distance(const vector3& point, const vector3& begin, const vector3& end)
 {
+  const vector3 chord  = end - begin;
+  const auto    length = chord.squaredNorm();
+  const auto    t      = length > scalar(0) ? std::clamp((point - begin).dot(chord) / length, scalar(0), scalar(1)) : scalar(0);
+  return (point - (begin + t * chord)).norm();
+}
+
+// Advances the position by the duration through the cells of the trilinear vector field (blended linearly with the next
+// one by the weight, if any). The corner vectors of each cell are read once, and the position is advanced by RK4 steps
+// on the trilinear polynomial of the cell, each sized to cross the nearest face in the direction of motion (estimated
+// from the vector at its start), i.e. a few steps per cell irrespective of the duration. Stops once the position leaves
+// the block (per the contains predicate) and returns the remaining duration, with the sign of the duration, which the
+// neighbor continues in its cells. The same substeps follow as on a single block, hence the trace does not depend on
+// the partitioning.
+template <typename contains_type>
+static scalar trace_cells(const regular_vector_field_3d& vector_field, const regular_vector_field_3d* next_vector_field, const scalar weight, const contains_type& contains, vector3& position, const scalar duration)
+{
+  constexpr std::size_t maximum_steps = 256;          // Near critical points, the last one covers the remaining duration.
+  constexpr scalar      overshoot     = scalar(0.01); // Of a cell, such that steps end beyond the face.
+
+  const auto  direction = duration < scalar(0) ? scalar(-1) : scalar(1);
+  const auto& shape     = vector_field.data.shape();
+  const auto& spacing   = vector_field.spacing;
+
+  std::array<std::size_t, 3> cell    {shape[0], shape[1], shape[2]}; // None loaded.
+  std::array<vector3, 8>     corners ;
+  vector3                    origin  ;
+  const auto evaluate = [&] (const vector3& x)
+  {
+    const vector3 t  = (x - origin).cwiseQuotient(spacing);
+    const vector3 x0 = corners[0] + t[0] * (corners[4] - corners[0]), x1 = corners[1] + t[0] * (corners[5] - corners[1]);
+    const vector3 x2 = corners[2] + t[0] * (corners[6] - corners[2]), x3 = corners[3] + t[0] * (corners[7] - corners[3]);
+    const vector3 y0 = x0 + t[1] * (x2 - x0), y1 = x1 + t[1] * (x3 - x1);
+    return vector3(direction * (y0 + t[2] * (y1 - y0)));
+  };
+
+  auto remaining = std::abs(duration);
+  for (std::size_t step = 0; step < maximum_steps && remaining > scalar(0); ++step)
+  {
+    std::array<std::size_t, 3> index;
+    for (auto i = 0; i < 3; ++i)
+      index[i] = static_cast<std::size_t>(std::clamp(std::floor((position[i] - vector_field.offset[i]) / spacing[i]), scalar(0), scalar(shape[i] > 1 ? shape[i] - 2 : 0)));
+    if (index != cell)
+    {
+      cell = index;
+      for (std::size_t corner = 0; corner < 8; ++corner)
+      {
+        const std::array<std::size_t, 3> corner_index {cell[0] + (corner >> 2 & 1), cell[1] + (corner >> 1 & 1), cell[2] + (corner & 1)};
+        corners[corner] = vector_field.data(corner_index);
+        if (next_vector_field)
+          corners[corner] = (scalar(1) - weight) * corners[corner] + weight * next_vector_field->data(corner_index);
+      }
+      for (auto i = 0; i < 3; ++i)
+        origin[i] = vector_field.offset[i] + scalar(cell[i]) * spacing[i];
+    }
+
+    const auto k1 = evaluate(position);
+    auto       dt = remaining;
+    if (step + 1 < maximum_steps)
+      for (auto i = 0; i < 3; ++i)
+      {
+        // Dimensions in which the position is beyond the (clamped) cell have no face to cross.
+        const auto local = (position[i] - origin[i]) / spacing[i];
+        if (k1[i] != scalar(0) && local >= scalar(0) && local <= scalar(1))
+          dt = std::min(dt, ((k1[i] > scalar(0) ? scalar(1) - local : local) + overshoot) * spacing[i] / std::abs(k1[i]));
+      }
+
+    const auto k2 = evaluate(position + dt / 2 * k1);
+    const auto k3 = evaluate(position + dt / 2 * k2);
+    const auto k4 = evaluate(position + dt     * k3);
+    position  += dt / 6 * (k1 + 2 * k2 + 2 * k3 + k4);
+    remaining -= dt;
+    if (!contains(position))
+      break;
+  }
+  return remaining > scalar(0) ? direction * remaining : scalar(0);
+}
+
+// In-place inclusive prefix sum. An exclusive one if the first value is zero.
+static void inclusive_scan(std::vector<std::size_t>& values)
+{
+  tbb::parallel_scan(tbb::blocked_range<std::size_t>(0, values.size()), std::size_t(0), [&] (const tbb::blocked_range<std::size_t>& range, std::size_t sum, const bool final)
+  {
+    for (auto i = range.begin(); i < range.end(); ++i)
+    {
+      sum += values[i];
+      if (final)
+        values[i] = sum;
+    }
+    return sum;
+  }, std::plus<std::size_t>());
+}
+
+particle_advector::particle_advector(domain_partitioner* partitioner, const size particles_per_round, const std::string& load_balancer, const std::string& integrator, const scalar step_size, const bool gather_particles, const bool record, const bool huge_pages, numa_arenas* arenas, const bool generate_indices, const bool use_64_bit_indices, const std::string& attribute, const std::string& recording, const scalar recording_parameter, const bool quantize, const std::vector<size>& horizons, const bool integrate_deformation, const std::string& interpolation)
+: partitioner_          (partitioner)
+, particles_per_round_  (particles_per_round)
+, step_size_            (step_size)
+, gather_particles_     (gather_particles)
+, record_               (record)
+, huge_pages_           (huge_pages)
+, arenas_               (arenas)
+, generate_indices_     (generate_indices)
+, use_64_bit_indices_   (use_64_bit_indices)
+, recording_parameter_  (recording_parameter)
+, quantize_             (quantize)
+, horizons_             (horizons)
+, integrate_deformation_(integrate_deformation)
+{
+  if      (recording     == "every_nth"                             ) recording_     = recording::every_nth;
+  else if (recording     == "arc_length"                            ) recording_     = recording::arc_length;
+  else if (recording     == "simplified"                            ) recording_     = recording::simplified;
+  else                                                                recording_     = recording::all;
+
+  if      (attribute     == "angular_velocity"                      ) attribute_     = attribute::angular_velocity;
+  else if (attribute     == "velocity"                              ) attribute_     = attribute::velocity;
+  else                                                                attribute_     = attribute::none;
+
+  if      (interpolation == "cubic"                                 ) interpolation_ = interpolation::cubic;
+  else                                                                interpolation_ = interpolation::linear;
+
   if      (load_balancer == "diffuse_constant"                      ) load_balancer_ = load_balancer::diffuse_constant;
   else if (load_balancer == "diffuse_lesser_average"                ) load_balancer_ = load_balancer::diffuse_lesser_average;
   else if (load_balancer == "diffuse_greater_limited_lesser_average") load_balancer_ = load_balancer::diffuse_greater_limited_lesser_average;
@@ -34,6 +157,27 @@ particle_advector::particle_advector(domain_partitioner* partitioner, const size
   else if (integrator    == "runge_kutta_fehlberg_78"               ) integrator_    = runge_kutta_fehlberg_78_integrator     <vector3>();
   else if (integrator    == "adams_bashforth_2"                     ) integrator_    = adams_bashforth_2_integrator           <vector3>();
   else if (integrator    == "adams_bashforth_moulton_2"             ) integrator_    = adams_bashforth_moulton_2_integrator   <vector3>();
+  else if (integrator    == "cell_stepping"                         ) cell_stepping_ = true; // See trace_cells.
+
+  // Cell stepping traces the trilinear interpolant, hence the bounds, attributes and Jacobians interpolate linearly too.
+  if (cell_stepping_)
+    interpolation_ = interpolation::linear;
+
+  // The deformation gradient is integrated by the same method as the position, by runge_kutta_4 if cell stepping.
+  if      (integrator    == "euler"                                 ) deformation_integrator_ = euler_integrator                       <flattened_matrix3>();
+  else if (integrator    == "modified_midpoint"                     ) deformation_integrator_ = modified_midpoint_integrator           <flattened_matrix3>();
+  else if (integrator    == "runge_kutta_4"                         ) deformation_integrator_ = runge_kutta_4_integrator               <flattened_matrix3>();
+  else if (integrator    == "runge_kutta_cash_karp_54"              ) deformation_integrator_ = runge_kutta_cash_karp_54_integrator    <flattened_matrix3>();
+  else if (integrator    == "runge_kutta_dormand_prince_5"          ) deformation_integrator_ = runge_kutta_dormand_prince_5_integrator<flattened_matrix3>();
+  else if (integrator    == "runge_kutta_fehlberg_78"               ) deformation_integrator_ = runge_kutta_fehlberg_78_integrator     <flattened_matrix3>();
+  else if (integrator    == "adams_bashforth_2"                     ) deformation_integrator_ = adams_bashforth_2_integrator           <flattened_matrix3>();
+  else if (integrator    == "adams_bashforth_moulton_2"             ) deformation_integrator_ = adams_bashforth_moulton_2_integrator   <flattened_matrix3>();
+  else if (integrator    == "cell_stepping"                         ) deformation_integrator_ = runge_kutta_4_integrator               <flattened_matrix3>();
+
+#ifndef DPA_DEFORMATION_SUPPORT
+  if (integrate_deformation_)
+    std::cout << "Deformation gradients are not integrated since particles do not hold them. Declare DPA_DEFORMATION_SUPPORT and rebuild." << std::endl;
+#endif
 }
 
 particle_advector::output      particle_advector::advect                  (const vector_field_map& vector_fields, particle_vector& particles)
@@ -46,11 +190,11 @@ particle_advector::output      particle_advector::advect                  (const
     auto round_state = compute_round_state     (state);
                        allocate_integral_curves(       round_state, output);
                        advect                  (state, round_state, output);
+                       prune_integral_curves   (       round_state, output);
                        load_balance_collect    (state, round_state, output);
                        out_of_bounds_distribute(state, round_state);
   }
   gather_particles     (output);
-  prune_integral_curves(output);
   return output;
 }
 
@@ -302,72 +446,158 @@ particle_advector::round_state particle_advector::compute_round_state     (
 
   if (record_)
   {
-    round_state.curve_stride = maximum_iterations + 2; // Two more vertices per curve; one for initial position, one for termination vertex.
-    round_state.vertex_count = round_state.particle_count * round_state.curve_stride;
+    // Each curve is allocated for its own remaining iterations rather than those of the longest curve of the round. Two
+    // more vertices per curve; one for initial position, one for termination vertex.
+    auto curve_count = std::size_t(0);
+    for (auto& pair : round_state.round_particles)
+      curve_count += pair.second;
+
+    // Particles advance at most until they pause, if unsteady.
+    const auto pause_remaining_iterations = state.pause_remaining_iterations();
+
+    round_state.curve_offsets .resize(curve_count + 1);
+    round_state.curve_sizes   .resize(curve_count);
+    round_state.step_counts   .resize(curve_count);
+    round_state.curve_ids     .resize(curve_count);
+    round_state.curve_segments.resize(curve_count);
+    auto curve_offset = std::size_t(0);
+    for (auto& pair : round_state.round_particles)
+    {
+      auto& particle_vector = pair.first.get();
+      auto  particle_count  = pair.second;
+      tbb::parallel_for(std::size_t(0), particle_count, std::size_t(1), [&] (const std::size_t particle_index)
+      {
+        round_state.curve_offsets[curve_offset + particle_index + 1] = particle_vector[particle_vector.size() - particle_count + particle_index].remaining_iterations - pause_remaining_iterations + 2;
+      });
+      curve_offset += particle_count;
+    }
+    inclusive_scan(round_state.curve_offsets);
+
+    round_state.vertex_count         = round_state.curve_offsets.back();
+    round_state.strided_vertex_count = curve_count * (maximum_iterations - std::min(maximum_iterations, pause_remaining_iterations) + 2);
   }
 
   return round_state;
 }
-void                           particle_advector::allocate_integral_curves(                    const round_state& round_state, output& output) 
+void                           particle_advector::allocate_integral_curves(                          round_state& round_state, output& output) 
 {
   if (!record_) return;
 
-  output.integral_curves.emplace_back().vertices.resize(round_state.vertex_count, invalid_value<vector3>());
+  if (attribute_ != attribute::none)
+  {
+    round_state.curve_attributes = attribute_vector(allocator<scalar>(allocation_policy {true, huge_pages_}));
+    round_state.curve_attributes.resize(round_state.vertex_count);
+  }
+
+  // Construction is deferred: every vertex up to the terminal one of each curve is written by advect, the rest is pruned.
+  output.integral_curves.push_back(integral_curve {integral_curve::vertex_vector(allocator<vector3>(allocation_policy {true, huge_pages_}))});
+  output.integral_curves.back().vertices.resize(round_state.vertex_count);
 }
 void                           particle_advector::advect                  (      state& state,       round_state& round_state, output& output)
 {
+  output.horizon_particles.resize(horizons_.size());
+
   auto particle_index_offset = size(0);
   for (auto& pair : round_state.round_particles)
   {
     auto& particle_vector = pair.first ;
     auto  particle_count  = pair.second;
 
-    tbb::parallel_for(std::size_t(0), particle_count, std::size_t(1), [&] (const std::size_t particle_index)
+    const auto pause_remaining_iterations = state.pause_remaining_iterations();
+    const auto advect_particle            = [&] (const std::size_t particle_index)
     {
-      auto& particle        = particle_vector.get()[particle_vector.get().size() - particle_count + particle_index];
-      auto& vector_field    = state.vector_fields.at(particle.relative_direction);
-      auto  bounds          = aabb3(vector_field.offset, vector_field.offset + vector_field.size);
-      auto  integrator      = integrator_;
-      auto  iteration_index = std::size_t(0);
+      auto& particle               = particle_vector.get()[particle_vector.get().size() - particle_count + particle_index];
+      auto& vector_field           = state.vector_fields.at(particle.relative_direction);
+      auto  bounds                 = interpolation_bounds(vector_field);
+      auto  integrator             = integrator_;
+      auto  deformation_integrator = deformation_integrator_;
+      auto  iteration_index        = std::size_t(0);
+      auto  curve_offset           = record_ ? round_state.curve_offsets[particle_index_offset + particle_index] : std::size_t(0);
+      auto  previous_direction     = vector3(); // Zero for the first vertex, as in the color_generator.
+      auto  vertices               = record_                                  ? output.integral_curves.back().vertices.data() + curve_offset : nullptr;
+      auto  attributes             = record_ && attribute_ != attribute::none ? round_state.curve_attributes        .data() + curve_offset : nullptr;
+      auto  anchor                 = std::size_t(0); // The last recorded vertex.
+      auto  pending                = std::size_t(0); // Positions held after the anchor by the simplification.
+      auto  slot                   = std::size_t(0); // The vertex of the last position, if held.
+      auto  held                   = true;
+      auto  arc_length             = scalar(0);      // Since the last recorded vertex.
 
       if (record_)
-        output.integral_curves.back().vertices[(particle_index_offset + particle_index) * round_state.curve_stride] = particle.position;
+      {
+        vertices[0] = particle.position;
+        round_state.curve_ids     [particle_index_offset + particle_index] = particle.id;
+        round_state.curve_segments[particle_index_offset + particle_index] = particle.segment;
+      }
+      ++particle.segment; // Before the particle is handed over to other ranks below.
 
-      for ( ; particle.remaining_iterations > 0; ++iteration_index, --particle.remaining_iterations)
+      const auto hand_over = [&] ()
       {
-        if (!vector_field.contains(particle.position))
+        if (particle.relative_direction == center) // if non-load balanced particle, send to neighbor process.
         {
-          if (particle.relative_direction == center) // if non-load balanced particle, send to neighbor process.
-          {
-            std::optional<relative_direction> direction;
-            if      (particle.position[0] < bounds.min()[0]) direction = negative_x;
-            else if (particle.position[0] > bounds.max()[0]) direction = positive_x;
-            else if (particle.position[1] < bounds.min()[1]) direction = negative_y;
-            else if (particle.position[1] > bounds.max()[1]) direction = positive_y;
-            else if (particle.position[2] < bounds.min()[2]) direction = negative_z;
-            else if (particle.position[2] > bounds.max()[2]) direction = positive_z;
-            
-            if (direction && round_state.out_of_bounds_particles.find(direction.value()) != round_state.out_of_bounds_particles.end())
-              round_state.out_of_bounds_particles.at(direction.value()).push_back(particle);
-            else
-              output.inactive_particles.push_back(particle);
-          }
-          else // if load balanced particle, send to original process which will then send it to neighbor process.
-          {
-            round_state.load_balanced_out_of_bounds_particles.at(particle.relative_direction).push_back(particle);
-          }
+          const auto direction = out_of_bounds_direction(bounds, particle.position);
+          
+          if (direction && round_state.out_of_bounds_particles.find(direction.value()) != round_state.out_of_bounds_particles.end())
+            round_state.out_of_bounds_particles.at(direction.value()).push_back(particle);
+          else
+            deactivate(particle, output);
+        }
+        else // if load balanced particle, send to original process which will then send it to neighbor process.
+        {
+          round_state.load_balanced_out_of_bounds_particles.at(particle.relative_direction).push_back(particle);
+        }
+      };
+
+      // The vector at a position and time, linear in time between the slices, and the time at the current step.
+      const auto weight       = [&] (const scalar time)
+      {
+        return state.interval ? std::clamp((time - state.interval->begin_time) / state.interval->duration, scalar(0), scalar(1)) : scalar(0);
+      };
+      const auto sample       = [&] (const vector3& position, const scalar time)
+      {
+        auto result = interpolate(vector_field, position);
+        if (state.interval)
+          result = (scalar(1) - weight(time)) * result + weight(time) * interpolate(state.interval->next_vector_fields->at(particle.relative_direction), position);
+        return result;
+      };
+      const auto current_time = [&] ()
+      {
+        return state.interval ? scalar(state.interval->seed_iterations - particle.remaining_iterations) * step_size_ : scalar(0);
+      };
+
+      for ( ; particle.remaining_iterations > pause_remaining_iterations; ++iteration_index, --particle.remaining_iterations)
+      {
+        if (!interpolation_contains(vector_field, bounds, particle.position))
+        {
+          hand_over();
           break;
         }
 
-        const auto vector = vector_field.interpolate(particle.position);
+        const auto time   = current_time();
+        const auto vector = sample(particle.position, time);
         if (vector.isZero())
         {
-          output.inactive_particles.push_back(particle);
+          deactivate(particle, output);
           break;
         }
 
-        const auto system = [&] (const vector3& x, vector3& dxdt, const float t) { dxdt = vector3(vector[2], vector[1], vector[0]); }; // Data-spacific.
-        if      (std::holds_alternative<euler_integrator<vector3>>                       (integrator))
+        // Linear interpolation samples the field once per step. Cubic interpolation is smooth enough for the integrators to
+        // attain their order, hence they sample it at each of their stages.
+        const auto previous_position = particle.position;
+        const auto step_time         = iteration_index * step_size_;
+        const auto system            = [&] (const vector3& x, vector3& dxdt, const float t) // The loader normalizes the layout.
+        {
+          if (interpolation_ == interpolation::linear || (t == step_time && x == previous_position))
+            dxdt = vector;
+          else
+            dxdt = sample(x, time + (t - step_time));
+        };
+
+        // Cell stepping continues a step interrupted at the bounds of the previous block with its remainder (and the weight
+        // of the time at its start).
+        const auto step_duration = cell_stepping_ && particle.step_remainder != scalar(0) ? particle.step_remainder : step_size_;
+        if      (cell_stepping_)
+          particle.step_remainder = trace_cells(vector_field, state.interval ? &state.interval->next_vector_fields->at(particle.relative_direction) : nullptr, weight(time), [&] (const vector3& position) { return interpolation_contains(vector_field, bounds, position); }, particle.position, step_duration);
+        else if (std::holds_alternative<euler_integrator<vector3>>                       (integrator))
           std::get<euler_integrator<vector3>>                       (integrator).do_step(system, particle.position, iteration_index * step_size_, step_size_);
         else if (std::holds_alternative<modified_midpoint_integrator<vector3>>           (integrator))
           std::get<modified_midpoint_integrator<vector3>>           (integrator).do_step(system, particle.position, iteration_index * step_size_, step_size_);
@@ -383,28 +613,200 @@ void                           particle_advector::advect                  (
           std::get<adams_bashforth_2_integrator<vector3>>           (integrator).do_step(system, particle.position, iteration_index * step_size_, step_size_);
         else if (std::holds_alternative<adams_bashforth_moulton_2_integrator<vector3>>   (integrator))
           std::get<adams_bashforth_moulton_2_integrator<vector3>>   (integrator).do_step(system, particle.position, iteration_index * step_size_, step_size_);
+
+#ifdef DPA_DEFORMATION_SUPPORT
+        if (integrate_deformation_)
+        {
+          // The variational equation dF/dt = J F, with the Jacobian of the field at the position and time before the
+          // step (as the vector of the position is, hence linear in time between the slices), over the part of the step
+          // taken.
+          const auto        gradient    = [&] (const regular_vector_field_3d& field) -> matrix3
+          {
+            return interpolation_ == interpolation::cubic ? field.interpolate_cubic_gradient(previous_position) : field.interpolate_gradient(previous_position);
+          };
+          matrix3           jacobian    = gradient(vector_field);
+          if (state.interval)
+            jacobian = (scalar(1) - weight(time)) * jacobian + weight(time) * gradient(state.interval->next_vector_fields->at(particle.relative_direction));
+          const auto        system      = [&] (const flattened_matrix3& f, flattened_matrix3& dfdt, const float t) { Eigen::Map<matrix3>(dfdt.data()) = jacobian * Eigen::Map<const matrix3>(f.data()); };
+          flattened_matrix3 deformation = Eigen::Map<const flattened_matrix3>(particle.deformation.data());
+          std::visit([&] (auto& cast_integrator) { cast_integrator.do_step(system, deformation, iteration_index * step_size_, step_duration - particle.step_remainder); }, deformation_integrator);
+          Eigen::Map<flattened_matrix3>(particle.deformation.data()) = deformation;
+        }
+#endif
+
+        // The remaining iterations are decremented after the step, unless it is interrupted.
+        if (particle.step_remainder == scalar(0))
+          for (std::size_t horizon = 0; horizon < horizons_.size(); ++horizon)
+            if (particle.remaining_iterations - 1 == horizons_[horizon])
+              output.horizon_particles[horizon].push_back(particle);
         
         if (record_)
-          output.integral_curves.back().vertices[(particle_index_offset + particle_index) * round_state.curve_stride + iteration_index + 1] = particle.position;
+        {
+          // The attribute of the previous position is complete once its successor is known.
+          const vector3 direction = (particle.position - previous_position).normalized();
+          if      (attributes && held && attribute_ == attribute::angular_velocity)
+            attributes[slot] = std::atan2(previous_direction.cross(direction).norm(), previous_direction.dot(direction));
+          else if (attributes && held && attribute_ == attribute::velocity)
+            attributes[slot] = vector.norm();
+          previous_direction = direction;
+
+          if      (recording_ == recording::every_nth)
+            held = (iteration_index + 1) % std::max<std::size_t>(static_cast<std::size_t>(recording_parameter_), 1) == 0;
+          else if (recording_ == recording::arc_length)
+          {
+            arc_length += (particle.position - previous_position).norm();
+            held        = arc_length >= recording_parameter_;
+            if (held)
+              arc_length = scalar(0);
+          }
+          else
+            held = true;
+
+          if      (recording_ == recording::simplified)
+          {
+            // Positions are held after the anchor until one of them deviates more than epsilon from the chord between
+            // the anchor and the new position, upon which the previous position becomes the anchor.
+            vertices[anchor + ++pending] = particle.position;
+            auto deviates = pending > simplification_window;
+            for (std::size_t i = 1; i < pending && !deviates; ++i)
+              deviates = chord_distance(vertices[anchor + i], vertices[anchor], particle.position) > recording_parameter_;
+            if (deviates)
+            {
+              vertices[anchor + 1] = vertices[anchor + pending - 1];
+              if (attributes)
+                attributes[anchor + 1] = attributes[anchor + pending - 1];
+              vertices[++anchor + 1] = particle.position;
+              pending = 1;
+            }
+            slot = anchor + pending;
+          }
+          else if (held)
+          {
+            vertices[++anchor] = particle.position;
+            slot = anchor;
+          }
+        }
+
+        // An interrupted step is continued by the neighbor, without decrementing the remaining iterations.
+        if (particle.step_remainder != scalar(0))
+        {
+          ++iteration_index;
+          hand_over();
+          break;
+        }
       }
 
       if (record_)
-        output.integral_curves.back().vertices[(particle_index_offset + particle_index) * round_state.curve_stride + iteration_index + 1] = terminal_value<vector3>();
+      {
+        // The last position always ends the curve.
+        if      (!held)
+          vertices[++anchor] = particle.position;
+        else if (slot != anchor)
+          vertices[++anchor] = vertices[slot];
+        vertices[anchor + 1] = terminal_value<vector3>();
+        round_state.curve_sizes[particle_index_offset + particle_index] = anchor + 2;
+        round_state.step_counts[particle_index_offset + particle_index] = iteration_index + 2;
+
+        if (attributes)
+        {
+          // The last vertex has no successor, hence no angular velocity, and the velocity only if it is within the field.
+          attributes[anchor    ] = attribute_ == attribute::velocity && interpolation_contains(vector_field, bounds, particle.position) ? sample(particle.position, current_time()).norm() : scalar(0);
+          attributes[anchor + 1] = scalar(0);
+        }
+      }
 
-      if (particle.remaining_iterations == 0)
-        output.inactive_particles.push_back(particle);
-    });
+      if      (particle.remaining_iterations == 0)
+        deactivate(particle, output);
+      else if (particle.remaining_iterations == pause_remaining_iterations) // Paused until the next time interval, on the original rank.
+      {
+        if (particle.relative_direction == center)
+          state.paused_particles.push_back(particle);
+        else
+          round_state.load_balanced_out_of_bounds_particles.at(particle.relative_direction).push_back(particle);
+      }
+    };
+
+    if (arenas_)
+    {
+      // Bucket the particles by the node which placed the slab of the vector field they start in.
+      std::vector<std::vector<std::size_t>> node_particle_indices(arenas_->size());
+      for (std::size_t particle_index = 0; particle_index < particle_count; ++particle_index)
+      {
+        auto& particle     = particle_vector.get()[particle_vector.get().size() - particle_count + particle_index];
+        auto& vector_field = state.vector_fields.at(particle.relative_direction);
+        auto  cell         = std::floor((particle.position[0] - vector_field.offset[0]) / vector_field.spacing[0]);
+        node_particle_indices[arenas_->node(static_cast<std::size_t>(std::max(cell, scalar(0))), vector_field.data.shape()[0])].push_back(particle_index);
+      }
+
+      arenas_->execute([&] (const std::size_t node)
+      {
+        auto& particle_indices = node_particle_indices[node];
+        tbb::parallel_for(std::size_t(0), particle_indices.size(), std::size_t(1), [&] (const std::size_t index)
+        {
+          advect_particle(particle_indices[index]);
+        });
+      });
+    }
+    else
+      tbb::parallel_for(std::size_t(0), particle_count, std::size_t(1), advect_particle);
 
     particle_vector.get().resize(particle_vector.get().size() - particle_count);
     particle_index_offset += particle_count;
   }
 }
-void                           particle_advector::prune_integral_curves   (                                                    output& output) 
+void                           particle_advector::prune_integral_curves   (              const round_state& round_state, output& output) 
 {
   if (!record_) return;
 
-  auto& curves = output.integral_curves.back().vertices;
-  curves.erase(std::remove(curves.begin(), curves.end(), invalid_value<vector3>()), curves.end());
+  // Compacts the recorded vertices of each curve to the offsets of an exclusive prefix sum of their sizes.
+  std::vector<std::size_t> offsets(round_state.curve_sizes.size() + 1, 0);
+  std::copy(round_state.curve_sizes.begin(), round_state.curve_sizes.end(), offsets.begin() + 1);
+  inclusive_scan(offsets);
+
+  auto& curve    = output.integral_curves.back();
+  auto  pruned   = integral_curve::vertex_vector(allocator<vector3>(allocation_policy {true, huge_pages_}));
+  pruned.resize(offsets.back());
+  if (attribute_ != attribute::none)
+    curve.colors = std::vector<scalar>(offsets.back());
+
+  // Each curve of n vertices (including the terminal one) has n - 2 segments, hence its indices begin at twice the
+  // number of vertices preceding it minus two per preceding curve.
+  const auto curve_count = round_state.curve_sizes.size();
+  if (generate_indices_)
+  {
+    use_64_bit_indices_
+      ? curve.indices = std::vector<std::uint64_t>(2 * (offsets.back() - 2 * curve_count))
+      : curve.indices = std::vector<std::uint32_t>(2 * (offsets.back() - 2 * curve_count));
+  }
+
+  tbb::parallel_for(std::size_t(0), curve_count, std::size_t(1), [&] (const std::size_t curve_index)
+  {
+    const auto source = round_state.curve_offsets[curve_index];
+    const auto target = offsets[curve_index];
+    const auto count  = round_state.curve_sizes  [curve_index];
+    std::copy(curve.vertices.begin() + source, curve.vertices.begin() + source + count, pruned.begin() + target);
+
+    if (attribute_ != attribute::none)
+      std::copy(round_state.curve_attributes.begin() + source, round_state.curve_attributes.begin() + source + count, std::get<std::vector<scalar>>(curve.colors).begin() + target);
+
+    if (generate_indices_)
+      std::visit([&] (auto& cast_indices)
+      {
+        const auto index_offset = 2 * (target - 2 * curve_index);
+        for (std::size_t vertex_index = 0; vertex_index + 2 < count; ++vertex_index)
+        {
+          cast_indices[index_offset + 2 * vertex_index    ] = target + vertex_index;
+          cast_indices[index_offset + 2 * vertex_index + 1] = target + vertex_index + 1;
+        }
+      }, curve.indices);
+  });
+  curve.vertices          = std::move(pruned);
+  curve.polyline_ids      = round_state.curve_ids;
+  curve.polyline_segments = round_state.curve_segments;
+  curve.polyline_offsets  = std::move(offsets);
+
+  if (quantize_)
+    curve.quantize();
 }
 void                           particle_advector::load_balance_collect    (      state& state,       round_state& round_state, output& output) 
 {
@@ -428,25 +830,21 @@ void                           particle_advector::load_balance_collect    (
       communicator->recv(partitions.at(neighbor.first).rank, 0, particles);
       
       auto& vector_field = state.vector_fields.at(center);
-      auto  bounds       = aabb3(vector_field.offset, vector_field.offset + vector_field.size);
+      auto  bounds       = interpolation_bounds(vector_field);
 
       tbb::parallel_for(std::size_t(0), particles.size(), std::size_t(1), [&] (const std::size_t particle_index)
       {
         auto& particle = particles[particle_index];
         particle.relative_direction = center;
 
-        std::optional<relative_direction> direction;
-        if      (particle.position[0] < bounds.min()[0]) direction = negative_x;
-        else if (particle.position[0] > bounds.max()[0]) direction = positive_x;
-        else if (particle.position[1] < bounds.min()[1]) direction = negative_y;
-        else if (particle.position[1] > bounds.max()[1]) direction = positive_y;
-        else if (particle.position[2] < bounds.min()[2]) direction = negative_z;
-        else if (particle.position[2] > bounds.max()[2]) direction = positive_z;
+        const auto direction = out_of_bounds_direction(bounds, particle.position);
 
-        if (direction && round_state.out_of_bounds_particles.find(direction.value()) != round_state.out_of_bounds_particles.end())
+        if      (direction && round_state.out_of_bounds_particles.find(direction.value()) != round_state.out_of_bounds_particles.end())
           round_state.out_of_bounds_particles.at(direction.value()).push_back(particle);
+        else if (!direction && state.interval && particle.remaining_iterations == state.pause_remaining_iterations()) // Paused within the block.
+          state.paused_particles.push_back(particle);
         else
-          output.inactive_particles.push_back(particle);
+          deactivate(particle, output);
       });
     }
 
@@ -478,26 +876,103 @@ void                           particle_advector::out_of_bounds_distribute(
     request.wait();
 #endif
 }
+void                           particle_advector::resume_paused_particles (      state& state,                                 output& output, const bool terminate)
+{
+  output.horizon_particles.resize(horizons_.size());
+  if (terminate)
+    tbb::parallel_for(std::size_t(0), state.paused_particles.size(), std::size_t(1), [&] (const std::size_t index)
+    {
+      deactivate(state.paused_particles[index], output);
+    });
+  else
+    state.active_particles   .insert (state.active_particles.end(), state.paused_particles.begin(), state.paused_particles.end());
+  state.paused_particles.clear();
+}
 void                           particle_advector::gather_particles        (                                                    output& output)
 {
   if (!gather_particles_) return;
 
 #ifdef DPA_FTLE_SUPPORT
-  std::vector<concurrent_particle_vector> sent    (partitioner_->cartesian_communicator()->size());
-  std::vector<concurrent_particle_vector> received(partitioner_->cartesian_communicator()->size());
-
-  tbb::parallel_for(std::size_t(0), output.inactive_particles.size(), std::size_t(1), [&] (const std::size_t index)
+  const auto gather = [&] (concurrent_particle_vector& particles)
   {
-    sent[output.inactive_particles[index].original_rank].push_back(output.inactive_particles[index]);
-  });
+    std::vector<concurrent_particle_vector> sent    (partitioner_->cartesian_communicator()->size());
+    std::vector<concurrent_particle_vector> received(partitioner_->cartesian_communicator()->size());
+
+    tbb::parallel_for(std::size_t(0), particles.size(), std::size_t(1), [&] (const std::size_t index)
+    {
+      sent[particles[index].original_rank].push_back(particles[index]);
+    });
+
+    boost::mpi::all_to_all(*partitioner_->cartesian_communicator(), sent, received);
 
-  boost::mpi::all_to_all(*partitioner_->cartesian_communicator(), sent, received);
+    particles.clear();
+    for (auto& received_particles : received)
+      particles.grow_by(received_particles.begin(), received_particles.end());
+  };
 
-  output.inactive_particles.clear();
-  for (auto& particles : received)
-    output.inactive_particles.grow_by(particles.begin(), particles.end());
+  gather(output.inactive_particles);
+  for (auto& horizon_particles : output.horizon_particles)
+    gather(horizon_particles);
 #else
   std::cout << "Particles are not gathered since original ranks are unavailable. Declare DPA_FTLE_SUPPORT and rebuild." << std::endl;
 #endif
 }
+void                           particle_advector::deactivate              (const particle_3d& particle,                        output& output) const
+{
+  output.inactive_particles.push_back(particle);
+  for (std::size_t horizon = 0; horizon < horizons_.size(); ++horizon)
+    if (horizons_[horizon] < particle.remaining_iterations)
+      output.horizon_particles[horizon].push_back(particle);
+}
+
+aabb3                          particle_advector::interpolation_bounds    (const regular_vector_field_3d& vector_field) const
+{
+  // The extent of the nodes rather than offset + size, such that particles in the last cell of a block are handed over
+  // to the neighbor (whose ghosted block starts at the last node) instead of being terminated.
+  vector3 minimum = vector_field.offset;
+  vector3 maximum = vector_field.offset;
+  for (auto i = 0; i < 3; ++i)
+  {
+    const auto first_index = std::round(vector_field.offset[i] / vector_field.spacing[i]);
+    const auto shape       = vector_field.data.shape()[i];
+    maximum[i] += scalar(shape - 1) * vector_field.spacing[i];
+    if (interpolation_ == interpolation::linear)
+      continue;
+    if (first_index > scalar(0))
+      minimum[i] += vector_field.spacing[i];
+    if (first_index + scalar(shape) < scalar(partitioner_->domain_size()[i]))
+      maximum[i] -= vector_field.spacing[i];
+  }
+  return aabb3(minimum, maximum);
+}
+bool                           particle_advector::interpolation_contains  (const regular_vector_field_3d& vector_field, const aabb3& bounds, const vector3& position) const
+{
+  if (interpolation_ == interpolation::linear)
+    return vector_field.contains(position);
+
+  for (auto i = 0; i < 3; ++i)
+    if (position[i] < bounds.min()[i] || position[i] > bounds.max()[i])
+      return false;
+  return true;
+}
+std::optional<relative_direction> particle_advector::out_of_bounds_direction(const aabb3& bounds, const vector3& position) const
+{
+  // Linear interpolation requires the cell beyond a position, hence the last node of a block is out of bounds (and
+  // within the ghosted block of the next one).
+  const auto beyond = [&] (const std::size_t dimension)
+  {
+    return interpolation_ == interpolation::linear ? position[dimension] >= bounds.max()[dimension] : position[dimension] > bounds.max()[dimension];
+  };
+  if      (position[0] < bounds.min()[0]) return negative_x;
+  else if (beyond(0))                     return positive_x;
+  else if (position[1] < bounds.min()[1]) return negative_y;
+  else if (beyond(1))                     return positive_y;
+  else if (position[2] < bounds.min()[2]) return negative_z;
+  else if (beyond(2))                     return positive_z;
+  return std::nullopt;
+}
+vector3                        particle_advector::interpolate             (const regular_vector_field_3d& vector_field, const vector3& position) const
+{
+  return interpolation_ == interpolation::cubic ? vector_field.interpolate_cubic(position) : vector_field.interpolate(position);
+}
 }
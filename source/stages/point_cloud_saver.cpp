@@ -0,0 +1,57 @@
+#include <dpa/stages/point_cloud_saver.hpp>
+
+#include <array>
+#include <filesystem>
+#include <fstream>
+
+#include <boost/algorithm/string/replace.hpp>
+#include <boost/mpi.hpp>
+#include <hdf5.h>
+
+#include <dpa/utility/xdmf.hpp>
+
+#undef min
+#undef max
+
+namespace dpa
+{
+point_cloud_saver::point_cloud_saver (domain_partitioner* partitioner, const std::string& filepath) 
+: partitioner_(partitioner)
+, filepath_   (std::filesystem::path(filepath).replace_extension(".rank_" + std::to_string(partitioner_->cartesian_communicator()->rank()) + "_points.h5").string())
+{
+
+}
+
+void point_cloud_saver::save(const point_cloud& point_cloud)
+{
+  if (point_cloud.positions.empty())
+    return;
+
+  const auto file                    = H5Fcreate(filepath_.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+
+  const auto positions_element_count = std::array<hsize_t, 2>{hsize_t(point_cloud.positions.size()), 3};
+  const auto positions_space         = H5Screate_simple(2, positions_element_count.data(), nullptr);
+  const auto positions_dataset       = H5Dcreate2(file, "positions", H5T_NATIVE_FLOAT, positions_space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  H5Dwrite(positions_dataset, H5T_NATIVE_FLOAT, positions_space, positions_space, H5P_DEFAULT, point_cloud.positions.data()->data());
+  H5Sclose(positions_space);
+  H5Dclose(positions_dataset);
+
+  const auto values_element_count    = hsize_t(point_cloud.values.size());
+  const auto values_space            = H5Screate_simple(1, &values_element_count, nullptr);
+  const auto values_dataset          = H5Dcreate2(file, "values", H5T_NATIVE_FLOAT, values_space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  H5Dwrite(values_dataset, H5T_NATIVE_FLOAT, values_space, values_space, H5P_DEFAULT, point_cloud.values.data());
+  H5Sclose(values_space);
+  H5Dclose(values_dataset);
+
+  H5Fclose(file);
+
+  auto xdmf = xdmf_body_points;
+  boost::replace_all(xdmf, "$FILEPATH"              , std::filesystem::path(filepath_).filename().string());
+  boost::replace_all(xdmf, "$POSITIONS_DATASET_NAME", "positions");
+  boost::replace_all(xdmf, "$VALUES_DATASET_NAME"   , "values");
+  boost::replace_all(xdmf, "$POINT_COUNT"           , std::to_string(point_cloud.positions.size()));
+
+  std::ofstream stream(filepath_ + ".xdmf");
+  stream << xdmf_header << xdmf << xdmf_footer;
+}
+}
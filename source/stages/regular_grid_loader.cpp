@@ -1,89 +1,454 @@
 #include <dpa/stages/regular_grid_loader.hpp>
 
+#include <algorithm>
 #include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+#include <boost/mpi.hpp>
+#include <nlohmann/json.hpp>
+
+#ifdef __unix__
+#include <unistd.h>
+#endif
 
 namespace dpa
 {
-regular_grid_loader::regular_grid_loader (domain_partitioner* partitioner, const std::string& filepath, const std::string& dataset_path, const std::string& spacing_path)
-: partitioner_ (partitioner )
-, filepath_    (filepath    )
-, dataset_path_(dataset_path)
-, spacing_path_(spacing_path)
+// Maps e.g. "zyx" to {2, 1, 0}.
+static std::array<std::size_t, 3> parse_order(const std::string& order)
 {
+  std::array<std::size_t, 3> result {};
+  if (order.size() != 3 || order.find('x') == std::string::npos || order.find('y') == std::string::npos || order.find('z') == std::string::npos)
+    throw std::invalid_argument("Invalid axis or component order: " + order + ". Expected a permutation of xyz.");
+  for (auto i = 0; i < 3; ++i)
+    result[i] = order[i] - 'x';
+  return result;
+}
+
+regular_grid_loader::regular_grid_loader (domain_partitioner* partitioner, const std::string& filepath, const std::string& dataset_path, const std::string& spacing_path, const std::string& axis_order, const std::string& component_order, const std::optional<std::string>& cache_directory, numa_arenas* arenas, const bool huge_pages)
+: partitioner_    (partitioner                )
+, arenas_         (arenas                     )
+, filepath_       (filepath                   )
+, dataset_path_   (dataset_path               )
+, spacing_path_   (spacing_path               )
+, cache_directory_(cache_directory            )
+, axis_order_     (parse_order(axis_order     ))
+, component_order_(parse_order(component_order))
+, huge_pages_     (huge_pages                 )
+{
+  if (cache_directory_)
+    std::filesystem::create_directories(*cache_directory_);
+
+  // A directory is expected to contain a manifest.json, which lists the block files relative to itself.
+  auto manifest_filepath = std::filesystem::path(filepath_);
+  if (std::filesystem::is_directory(manifest_filepath))
+    manifest_filepath /= "manifest.json";
+  if (manifest_filepath.extension() == ".json")
+  {
+    std::ifstream  file(manifest_filepath);
+    nlohmann::json json;
+    file >> json;
 
+    auto& manifest = manifest_.emplace();
+    manifest.format          = json.contains("format"         ) ? json["format"         ].get<std::string>() : "hdf5"         ;
+    manifest.axis_order      = json.contains("axis_order"     ) ? json["axis_order"     ].get<std::string>() : axis_order     ;
+    manifest.component_order = json.contains("component_order") ? json["component_order"].get<std::string>() : component_order;
+    manifest.dimensions = svector3(json["dimensions"][0].get<size>  (), json["dimensions"][1].get<size>  (), json["dimensions"][2].get<size>  ());
+    manifest.spacing    = vector3 (json["spacing"   ][0].get<scalar>(), json["spacing"   ][1].get<scalar>(), json["spacing"   ][2].get<scalar>());
+    for (auto& block : json["blocks"])
+      manifest.blocks.push_back(block_manifest::block
+      {
+        (manifest_filepath.parent_path() / block["filepath"].get<std::string>()).string(),
+        svector3(block["offset"][0].get<size>(), block["offset"][1].get<size>(), block["offset"][2].get<size>()),
+        svector3(block["size"  ][0].get<size>(), block["size"  ][1].get<size>(), block["size"  ][2].get<size>())
+      });
+
+    axis_order_      = parse_order(manifest.axis_order     );
+    component_order_ = parse_order(manifest.component_order);
+  }
 }
 
 svector3                                                        regular_grid_loader::load_dimensions   ()
 {
+  svector3 dimensions;
+  if (manifest_)
+    dimensions = manifest_->dimensions;
+  else
+  {
+    const auto property = H5Pcreate(H5P_FILE_ACCESS);
+    H5Pset_fapl_mpio(property, *partitioner_->communicator(), MPI_INFO_NULL);
+    const auto file     = H5Fopen (filepath_.c_str(), H5F_ACC_RDONLY, property);
+    const auto dataset  = H5Dopen2(file, dataset_path_.c_str(), H5P_DEFAULT);
+
+    // The spatial dimensions of time-variant datasets follow the time dimension.
+    std::array<hsize_t, 5> native_dimensions {0, 0, 0, 0, 0};
+    const auto space = H5Dget_space(dataset);
+    const auto rank  = H5Sget_simple_extent_ndims(space);
+    H5Sget_simple_extent_dims(space, native_dimensions.data(), nullptr);
+
+    H5Pclose(property);
+    H5Sclose(space   );
+    H5Dclose(dataset );
+    H5Fclose(file    );
+
+    const auto first = rank == 5 ? 1 : 0;
+    dimensions = svector3(native_dimensions[first], native_dimensions[first + 1], native_dimensions[first + 2]);
+  }
+
+  svector3 result;
+  for (auto i = 0; i < 3; ++i)
+    result[axis_order_[i]] = dimensions[i];
+  return result;
+}
+std::unordered_map<relative_direction, regular_vector_field_3d> regular_grid_loader::load_vector_fields(const bool load_neighbors)
+{
+  std::unordered_map<relative_direction, regular_vector_field_3d> vector_fields;
+
+  auto partitions = partitioner_->partitions();
+
+  std::vector<relative_direction> directions {center};
+  if (load_neighbors)
+  {
+    if (partitions.find(negative_x) != partitions.end()) directions.push_back(negative_x);
+    if (partitions.find(positive_x) != partitions.end()) directions.push_back(positive_x);
+    if (partitions.find(negative_y) != partitions.end()) directions.push_back(negative_y);
+    if (partitions.find(positive_y) != partitions.end()) directions.push_back(positive_y);
+    if (partitions.find(negative_z) != partitions.end()) directions.push_back(negative_z);
+    if (partitions.find(positive_z) != partitions.end()) directions.push_back(positive_z);
+  }
+
+  // Opening the file is collective, hence it is only skipped if the blocks of all ranks are cached.
+  auto locally_cached = cache_directory_.has_value();
+  for (auto& direction : directions)
+    locally_cached = locally_cached && load_cache_header(partitions.at(direction).ghosted_offset, partitions.at(direction).ghosted_block_size).has_value();
+  cached_ = boost::mpi::all_reduce(*partitioner_->communicator(), locally_cached, std::logical_and<bool>());
+
+  hid_t property = -1, file = -1, dataset = -1, spacing = -1;
+  if (!cached_ && !manifest_)
+  {
+    property = H5Pcreate(H5P_FILE_ACCESS);
+    H5Pset_fapl_mpio(property, *partitioner_->communicator(), MPI_INFO_NULL);
+    file     = H5Fopen (filepath_.c_str(), H5F_ACC_RDONLY, property);
+    dataset  = H5Dopen2(file, dataset_path_.c_str(), H5P_DEFAULT);
+    spacing  = H5Aopen (file, spacing_path_.c_str(), H5P_DEFAULT);
+  }
+
+  for (auto& direction : directions)
+  {
+    auto& partition = partitions.at(direction);
+    if (load_cached_vector_field(vector_fields, direction, partition.ghosted_offset, partition.ghosted_block_size))
+      continue;
+
+    load_vector_field(vector_fields, direction, partition.ghosted_offset, partition.ghosted_block_size, dataset, spacing);
+    if (cache_directory_)
+      save_cached_vector_field(vector_fields.at(direction), partition.ghosted_offset, partition.ghosted_block_size);
+  }
+
+  if (!cached_ && !manifest_)
+  {
+    H5Pclose(property);
+    H5Aclose(spacing );
+    H5Dclose(dataset );
+    H5Fclose(file    );
+  }
+
+  return vector_fields;
+}
+
+std::size_t                                                     regular_grid_loader::load_time_slice_count()
+{
+  if (manifest_)
+    return 1;
+
   const auto property = H5Pcreate(H5P_FILE_ACCESS);
   H5Pset_fapl_mpio(property, *partitioner_->communicator(), MPI_INFO_NULL);
   const auto file     = H5Fopen (filepath_.c_str(), H5F_ACC_RDONLY, property);
   const auto dataset  = H5Dopen2(file, dataset_path_.c_str(), H5P_DEFAULT);
 
-  std::array<hsize_t, 4> dimensions {0, 0, 0, 0};
+  std::array<hsize_t, 5> native_dimensions {0, 0, 0, 0, 0};
   const auto space = H5Dget_space(dataset);
-  H5Sget_simple_extent_dims(space, dimensions.data(), nullptr);
+  const auto rank  = H5Sget_simple_extent_ndims(space);
+  H5Sget_simple_extent_dims(space, native_dimensions.data(), nullptr);
 
   H5Pclose(property);
   H5Sclose(space   );
   H5Dclose(dataset );
   H5Fclose(file    );
 
-  return svector3(dimensions[0], dimensions[1], dimensions[2]);
+  return rank == 5 ? std::size_t(native_dimensions[0]) : 1;
 }
-std::unordered_map<relative_direction, regular_vector_field_3d> regular_grid_loader::load_vector_fields(const bool load_neighbors)
+void                                                            regular_grid_loader::prefetch_time_slice  (const std::size_t time_index, const bool load_neighbors)
 {
-  const auto property = H5Pcreate(H5P_FILE_ACCESS);
-  H5Pset_fapl_mpio(property, *partitioner_->communicator(), MPI_INFO_NULL);
-  const auto file     = H5Fopen (filepath_.c_str(), H5F_ACC_RDONLY, property);
-  const auto dataset  = H5Dopen2(file, dataset_path_.c_str(), H5P_DEFAULT);
-  const auto spacing  = H5Aopen (file, spacing_path_.c_str(), H5P_DEFAULT);
+  if (manifest_)
+    throw std::invalid_argument("Time-variant datasets can not be loaded from a manifest.");
 
-  std::unordered_map<relative_direction, regular_vector_field_3d> vector_fields;
+  // The partitions are copied, HDF5 is only called from this thread until the slice is loaded.
+  pending_time_slice_ = std::async(std::launch::async, [this, time_index, load_neighbors, partitions = partitioner_->partitions()] ()
+  {
+    std::unordered_map<relative_direction, regular_vector_field_3d> vector_fields;
 
-  auto partitions = partitioner_->partitions();
+    std::vector<relative_direction> directions {center};
+    if (load_neighbors)
+      for (auto direction : {negative_x, positive_x, negative_y, positive_y, negative_z, positive_z})
+        if (partitions.find(direction) != partitions.end())
+          directions.push_back(direction);
 
-  vector_fields.emplace(center, load_vector_field(partitions.at(center).ghosted_offset, partitions.at(center).ghosted_block_size, dataset, spacing));
-  if (load_neighbors)
-  {
-    if (partitions.find(negative_x) != partitions.end()) vector_fields.emplace(negative_x, load_vector_field(partitions.at(negative_x).ghosted_offset, partitions.at(negative_x).ghosted_block_size, dataset, spacing));
-    if (partitions.find(positive_x) != partitions.end()) vector_fields.emplace(positive_x, load_vector_field(partitions.at(positive_x).ghosted_offset, partitions.at(positive_x).ghosted_block_size, dataset, spacing));
-    if (partitions.find(negative_y) != partitions.end()) vector_fields.emplace(negative_y, load_vector_field(partitions.at(negative_y).ghosted_offset, partitions.at(negative_y).ghosted_block_size, dataset, spacing));
-    if (partitions.find(positive_y) != partitions.end()) vector_fields.emplace(positive_y, load_vector_field(partitions.at(positive_y).ghosted_offset, partitions.at(positive_y).ghosted_block_size, dataset, spacing));
-    if (partitions.find(negative_z) != partitions.end()) vector_fields.emplace(negative_z, load_vector_field(partitions.at(negative_z).ghosted_offset, partitions.at(negative_z).ghosted_block_size, dataset, spacing));
-    if (partitions.find(positive_z) != partitions.end()) vector_fields.emplace(positive_z, load_vector_field(partitions.at(positive_z).ghosted_offset, partitions.at(positive_z).ghosted_block_size, dataset, spacing));
-  }
-  
-  H5Pclose(property);
-  H5Aclose(spacing );
-  H5Dclose(dataset );
-  H5Fclose(file    );
+    const auto file    = H5Fopen (filepath_.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+    const auto dataset = H5Dopen2(file, dataset_path_.c_str(), H5P_DEFAULT);
+    const auto spacing = H5Aopen (file, spacing_path_.c_str(), H5P_DEFAULT);
+    for (auto& direction : directions)
+      load_vector_field(vector_fields, direction, partitions.at(direction).ghosted_offset, partitions.at(direction).ghosted_block_size, dataset, spacing, time_index);
+    H5Aclose(spacing);
+    H5Dclose(dataset);
+    H5Fclose(file   );
 
-  return vector_fields;
+    return vector_fields;
+  });
+}
+std::unordered_map<relative_direction, regular_vector_field_3d> regular_grid_loader::wait_time_slice      ()
+{
+  return pending_time_slice_.get();
 }
 
-regular_vector_field_3d                                         regular_grid_loader::load_vector_field (const svector3& offset, const svector3& size, hid_t dataset, hid_t spacing)
+bool                                                            regular_grid_loader::cached            () const
 {
-  regular_vector_field_3d vector_field {boost::multi_array<vector3, 3>(boost::extents[size[0]][size[1]][size[2]])};
+  return cached_;
+}
+
+void                                                            regular_grid_loader::load_vector_field (std::unordered_map<relative_direction, regular_vector_field_3d>& vector_fields, relative_direction direction, const svector3& offset, const svector3& size, hid_t dataset, hid_t spacing, const std::optional<std::size_t>& time_index)
+{
+  auto& vector_field = vector_fields.try_emplace(
+    direction,
+    regular_vector_field_3d::index_type {size[0], size[1], size[2]},
+    vector3::Zero(),
+    vector3::Zero(),
+    vector3::Zero(),
+    regular_vector_field_3d::allocator_type(allocation_policy {arenas_ != nullptr, huge_pages_})).first->second;
+  if (arenas_)
+    arenas_->first_touch(vector_field); // Prior to the (single threaded) read.
+
+  // The region in the layout of the dataset.
+  svector3 dataset_offset, dataset_size;
+  for (auto i = 0; i < 3; ++i)
+  {
+    dataset_offset[i] = offset[axis_order_[i]];
+    dataset_size  [i] = size  [axis_order_[i]];
+  }
+
+  // Transposed data is read into an intermediate, otherwise directly into the vector field.
+  const auto transpose    = axis_order_ != std::array<std::size_t, 3> {0, 1, 2};
+  auto       intermediate = regular_vector_field_3d::array_type(transpose ? regular_vector_field_3d::index_type {dataset_size[0], dataset_size[1], dataset_size[2]} : regular_vector_field_3d::index_type {0, 0, 0});
+  const auto data         = transpose ? intermediate.data() : vector_field.data.data();
 
-  const std::array<hsize_t, 4> native_offset {hsize_t(offset[0]), hsize_t(offset[1]), hsize_t(offset[2]), 0};
-  const std::array<hsize_t, 4> native_size   {hsize_t(size  [0]), hsize_t(size  [1]), hsize_t(size  [2]), 3};
-  const std::array<hsize_t, 4> native_stride {1, 1, 1, 1};
+  vector3 dataset_spacing;
+  if (manifest_)
+  {
+    load_blocks(data, dataset_offset, dataset_size);
+    dataset_spacing = manifest_->spacing;
+  }
+  else if (time_index)
+  {
+    // The file is opened through the default driver (see prefetch_time_slice), hence the default transfer property.
+    const std::array<hsize_t, 5> native_offset {hsize_t(*time_index), hsize_t(dataset_offset[0]), hsize_t(dataset_offset[1]), hsize_t(dataset_offset[2]), 0};
+    const std::array<hsize_t, 5> native_size   {1                   , hsize_t(dataset_size  [0]), hsize_t(dataset_size  [1]), hsize_t(dataset_size  [2]), 3};
+    const std::array<hsize_t, 5> native_stride {1, 1, 1, 1, 1};
 
-  const auto space    = H5Dget_space    (dataset);
-  const auto memspace = H5Screate_simple(4, native_size.data(), NULL);
-  const auto property = H5Pcreate       (H5P_DATASET_XFER);
-  H5Pset_dxpl_mpio   (property, H5FD_MPIO_INDEPENDENT);
-  H5Sselect_hyperslab(space, H5S_SELECT_SET, native_offset.data(), native_stride.data(), native_size.data(), nullptr);
-  H5Dread            (dataset, H5T_NATIVE_FLOAT, memspace, space, property, vector_field.data.origin()->data());
-  H5Pclose           (property);
-  H5Sclose           (memspace);
-  H5Sclose           (space);
+    const auto space    = H5Dget_space    (dataset);
+    const auto memspace = H5Screate_simple(5, native_size.data(), NULL);
+    H5Sselect_hyperslab(space, H5S_SELECT_SET, native_offset.data(), native_stride.data(), native_size.data(), nullptr);
+    H5Dread            (dataset, H5T_NATIVE_FLOAT, memspace, space, H5P_DEFAULT, data->data());
+    H5Sclose           (memspace);
+    H5Sclose           (space);
 
-  H5Aread            (spacing, H5T_NATIVE_FLOAT, vector_field.spacing.data());
+    H5Aread            (spacing, H5T_NATIVE_FLOAT, dataset_spacing.data());
+  }
+  else
+  {
+    const std::array<hsize_t, 4> native_offset {hsize_t(dataset_offset[0]), hsize_t(dataset_offset[1]), hsize_t(dataset_offset[2]), 0};
+    const std::array<hsize_t, 4> native_size   {hsize_t(dataset_size  [0]), hsize_t(dataset_size  [1]), hsize_t(dataset_size  [2]), 3};
+    const std::array<hsize_t, 4> native_stride {1, 1, 1, 1};
+
+    const auto space    = H5Dget_space    (dataset);
+    const auto memspace = H5Screate_simple(4, native_size.data(), NULL);
+    const auto property = H5Pcreate       (H5P_DATASET_XFER);
+    H5Pset_dxpl_mpio   (property, H5FD_MPIO_INDEPENDENT);
+    H5Sselect_hyperslab(space, H5S_SELECT_SET, native_offset.data(), native_stride.data(), native_size.data(), nullptr);
+    H5Dread            (dataset, H5T_NATIVE_FLOAT, memspace, space, property, data->data());
+    H5Pclose           (property);
+    H5Sclose           (memspace);
+    H5Sclose           (space);
+
+    H5Aread            (spacing, H5T_NATIVE_FLOAT, dataset_spacing.data());
+  }
+
+  for (auto i = 0; i < 3; ++i)
+    vector_field.spacing[axis_order_[i]] = dataset_spacing[i];
+  normalize(vector_field, transpose ? &intermediate : nullptr);
 
   vector_field.offset  = offset.cast<scalar>().array() * vector_field.spacing.array();
   vector_field.size    = size  .cast<scalar>().array() * vector_field.spacing.array();
-  return vector_field;
+}
+
+void                                                            regular_grid_loader::load_blocks       (vector3* data, const svector3& offset, const svector3& size) const
+{
+  for (auto& block : manifest_->blocks)
+  {
+    // Intersect the block with the requested region, skip the file if they do not overlap.
+    svector3 begin, end;
+    for (auto i = 0; i < 3; ++i)
+    {
+      begin[i] = std::max(offset[i]          , block.offset[i]                );
+      end  [i] = std::min(offset[i] + size[i], block.offset[i] + block.size[i]);
+    }
+    if ((begin.array() >= end.array()).any())
+      continue;
+
+    const svector3 extent = end - begin;
+    if (manifest_->format == "raw")
+    {
+      // Read contiguous runs along the last dimension.
+      std::ifstream stream(block.filepath, std::ios::binary);
+      for (auto x = begin[0]; x < end[0]; ++x)
+      {
+        for (auto y = begin[1]; y < end[1]; ++y)
+        {
+          const auto file_index   = ((x - block.offset[0]) * block.size[1] + (y - block.offset[1])) * block.size[2] + (begin[2] - block.offset[2]);
+          const auto memory_index = ((x - offset      [0]) * size      [1] + (y - offset      [1])) * size      [2] + (begin[2] - offset      [2]);
+          stream.seekg(file_index * sizeof(vector3));
+          stream.read (reinterpret_cast<char*>(data + memory_index), extent[2] * sizeof(vector3));
+        }
+      }
+    }
+    else
+    {
+      const std::array<hsize_t, 4> file_offset   {hsize_t(begin [0] - block.offset[0]), hsize_t(begin [1] - block.offset[1]), hsize_t(begin [2] - block.offset[2]), 0};
+      const std::array<hsize_t, 4> memory_offset {hsize_t(begin [0] - offset      [0]), hsize_t(begin [1] - offset      [1]), hsize_t(begin [2] - offset      [2]), 0};
+      const std::array<hsize_t, 4> memory_size   {hsize_t(size  [0])                  , hsize_t(size  [1])                  , hsize_t(size  [2])                  , 3};
+      const std::array<hsize_t, 4> native_size   {hsize_t(extent[0])                  , hsize_t(extent[1])                  , hsize_t(extent[2])                  , 3};
+      const std::array<hsize_t, 4> native_stride {1, 1, 1, 1};
+
+      // The default (sec2) driver is used, the file is not shared with other ranks through MPI-IO.
+      const auto file     = H5Fopen         (block.filepath.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+      const auto dataset  = H5Dopen2        (file, dataset_path_.c_str(), H5P_DEFAULT);
+      const auto space    = H5Dget_space    (dataset);
+      const auto memspace = H5Screate_simple(4, memory_size.data(), nullptr);
+      H5Sselect_hyperslab(space   , H5S_SELECT_SET, file_offset  .data(), native_stride.data(), native_size.data(), nullptr);
+      H5Sselect_hyperslab(memspace, H5S_SELECT_SET, memory_offset.data(), native_stride.data(), native_size.data(), nullptr);
+      H5Dread            (dataset, H5T_NATIVE_FLOAT, memspace, space, H5P_DEFAULT, data->data());
+      H5Sclose           (memspace);
+      H5Sclose           (space   );
+      H5Dclose           (dataset );
+      H5Fclose           (file    );
+    }
+  }
+}
+void                                                            regular_grid_loader::normalize         (regular_vector_field_3d& vector_field, const regular_vector_field_3d::array_type* data) const
+{
+  if (!data && component_order_ == std::array<std::size_t, 3> {0, 1, 2})
+    return;
+
+  vector_field.apply([&] (const regular_vector_field_3d::index_type& index, vector3& element)
+  {
+    auto source = element;
+    if (data)
+    {
+      regular_vector_field_3d::index_type dataset_index;
+      for (auto i = 0; i < 3; ++i)
+        dataset_index[i] = index[axis_order_[i]];
+      source = (*data)(dataset_index);
+    }
+    for (auto i = 0; i < 3; ++i)
+      element[component_order_[i]] = source[i];
+  });
+}
+
+std::string                                                     regular_grid_loader::cache_filepath    (const svector3& offset, const svector3& size) const
+{
+  // Keyed by dataset, layout, partition (ghosted offset and size) and ghost width.
+  const auto  source       = std::filesystem::absolute(filepath_).string() + ":" + dataset_path_ + ":" + spacing_path_ + ":" +
+    std::to_string(axis_order_     [0]) + std::to_string(axis_order_     [1]) + std::to_string(axis_order_     [2]) + ":" +
+    std::to_string(component_order_[0]) + std::to_string(component_order_[1]) + std::to_string(component_order_[2]);
+  const auto& ghost_size   = partitioner_->ghost_cell_size();
+  const auto  to_string    = [ ] (const svector3& value)
+  {
+    return std::to_string(value[0]) + "_" + std::to_string(value[1]) + "_" + std::to_string(value[2]);
+  };
+
+  const auto  filename     =
+    std::filesystem::path(filepath_).stem().string() + "." + std::to_string(std::hash<std::string>()(source)) +
+    ".o_" + to_string(offset) + ".s_" + to_string(size) + ".g_" + to_string(ghost_size) + ".block";
+  return (std::filesystem::path(*cache_directory_) / filename).string();
+}
+std::optional<regular_grid_loader::block_cache_header> regular_grid_loader::load_cache_header (const svector3& offset, const svector3& size) const
+{
+  if (!cache_directory_)
+    return std::nullopt;
+
+  std::ifstream stream(cache_filepath(offset, size), std::ios::binary);
+  if (!stream)
+    return std::nullopt;
+
+  block_cache_header header;
+  stream.read(reinterpret_cast<char*>(&header), sizeof(block_cache_header));
+  if (!stream ||
+      std::strncmp(header.magic.data(), "dpablock", header.magic.size()) != 0 ||
+      header.version      != 1                                                  ||
+      header.element_size != sizeof(vector3)                                    ||
+      header.source_time  != std::filesystem::last_write_time(filepath_).time_since_epoch().count() ||
+      header.shape[0]     != size[0] || header.shape[1] != size[1] || header.shape[2] != size[2])
+    return std::nullopt;
+
+  return header;
+}
+bool                                                            regular_grid_loader::load_cached_vector_field(std::unordered_map<relative_direction, regular_vector_field_3d>& vector_fields, relative_direction direction, const svector3& offset, const svector3& size) const
+{
+  const auto header = load_cache_header(offset, size);
+  if (!header)
+    return false;
+
+  // The data is not read but mapped, pages are faulted lazily on first access.
+  const auto file_region = std::make_shared<const dpa::file_region>(dpa::file_region {cache_filepath(offset, size), header->data_offset});
+  vector_fields.try_emplace(
+    direction,
+    regular_vector_field_3d::index_type {size[0], size[1], size[2]},
+    vector3(header->offset [0], header->offset [1], header->offset [2]),
+    vector3(header->size   [0], header->size   [1], header->size   [2]),
+    vector3(header->spacing[0], header->spacing[1], header->spacing[2]),
+    regular_vector_field_3d::allocator_type(file_region));
+  return true;
+}
+void                                                            regular_grid_loader::save_cached_vector_field(const regular_vector_field_3d& vector_field, const svector3& offset, const svector3& size) const
+{
+#ifdef __unix__
+  const auto page_size = static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+#else
+  const auto page_size = std::uint64_t(4096);
+#endif
+
+  block_cache_header header;
+  std::memcpy(header.magic.data(), "dpablock", header.magic.size());
+  header.version      = 1;
+  header.element_size = sizeof(vector3);
+  header.source_time  = std::filesystem::last_write_time(filepath_).time_since_epoch().count();
+  header.shape        = {size[0], size[1], size[2]};
+  header.offset       = {vector_field.offset [0], vector_field.offset [1], vector_field.offset [2]};
+  header.size         = {vector_field.size   [0], vector_field.size   [1], vector_field.size   [2]};
+  header.spacing      = {vector_field.spacing[0], vector_field.spacing[1], vector_field.spacing[2]};
+  header.data_offset  = ((sizeof(block_cache_header) + page_size - 1) / page_size) * page_size;
+
+  // Neighboring ranks may write the same block concurrently, hence each writes a temporary which is then renamed.
+  const auto filepath           = cache_filepath(offset, size);
+  const auto temporary_filepath = filepath + ".rank_" + std::to_string(partitioner_->communicator()->rank());
+  {
+    std::ofstream stream(temporary_filepath, std::ios::binary | std::ios::trunc);
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(block_cache_header));
+    stream.seekp(header.data_offset);
+    stream.write(reinterpret_cast<const char*>(vector_field.data.data()), vector_field.data.num_elements() * sizeof(vector3));
+  }
+  std::filesystem::rename(temporary_filepath, filepath);
 }
 }
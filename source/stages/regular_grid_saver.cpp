@@ -1,6 +1,10 @@
 #include <dpa/stages/regular_grid_saver.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <filesystem>
+#include <limits>
 #include <fstream>
 
 #include <boost/algorithm/string/replace.hpp>
@@ -9,11 +13,15 @@
 
 #include <dpa/utility/xdmf.hpp>
 
+#undef min
+#undef max
+
 namespace dpa
 {
 regular_grid_saver::regular_grid_saver (domain_partitioner* partitioner, const std::string& filepath) 
-: partitioner_(partitioner)
-, filepath_   (std::filesystem::path(filepath).replace_extension(".rank_" + std::to_string(partitioner_->cartesian_communicator()->rank()) + "_grid.h5").string())
+: partitioner_    (partitioner)
+, filepath_       (std::filesystem::path(filepath).replace_extension(".rank_" + std::to_string(partitioner_->cartesian_communicator()->rank()) + "_grid.h5").string())
+, shared_filepath_(std::filesystem::path(filepath).replace_extension(".grid.h5").string())
 {
 
 }
@@ -44,4 +52,69 @@ void regular_grid_saver::save(const regular_scalar_field_3d& scalar_field)
   std::ofstream stream(filepath_ + ".xdmf");
   stream << xdmf_header << xdmf << xdmf_footer;
 }
-}
\ No newline at end of file
+void regular_grid_saver::save_shared(const regular_scalar_field_3d& scalar_field, const vector3& stride)
+{
+  const auto& communicator = *partitioner_->cartesian_communicator();
+  const auto& partition    = partitioner_->partitions().at(center);
+  const auto& block_size   = partitioner_->block_size();
+  const auto& grid_size    = partitioner_->grid_size ();
+
+  // Each block contains the same number of strided cells, beginning after the strided ghost cells of the field.
+  std::array<hsize_t, 3> global_shape, block_shape, file_offset, memory_offset, memory_shape;
+  for (auto i = 0; i < 3; ++i)
+  {
+    block_shape  [i] = hsize_t(scalar(block_size[i]) / stride[i]);
+    global_shape [i] = block_shape[i] * grid_size[i];
+    file_offset  [i] = block_shape[i] * partition.multi_rank[i];
+    memory_offset[i] = hsize_t(scalar(partition.offset[i] - partition.ghosted_offset[i]) / stride[i]);
+    memory_shape [i] = scalar_field.data.shape()[i];
+  }
+
+  // Empty fields (e.g. without FTLE support) are empty on all ranks.
+  if (scalar_field.data.empty() || global_shape[0] * global_shape[1] * global_shape[2] == 0)
+    return;
+
+  // Chunks match the blocks, halved along their largest dimension while exceeding the 4 GB limit of HDF5.
+  auto chunk_shape = block_shape;
+  while (chunk_shape[0] * chunk_shape[1] * chunk_shape[2] * sizeof(float) >= std::numeric_limits<std::uint32_t>::max())
+  {
+    auto& largest = *std::max_element(chunk_shape.begin(), chunk_shape.end());
+    largest = (largest + 1) / 2;
+  }
+
+  const auto file_property     = H5Pcreate       (H5P_FILE_ACCESS);
+  H5Pset_fapl_mpio(file_property, communicator, MPI_INFO_NULL);
+  const auto create_property   = H5Pcreate       (H5P_DATASET_CREATE);
+  H5Pset_chunk    (create_property, 3, chunk_shape.data());
+  const auto transfer_property = H5Pcreate       (H5P_DATASET_XFER);
+  H5Pset_dxpl_mpio(transfer_property, H5FD_MPIO_COLLECTIVE);
+
+  const auto file              = H5Fcreate       (shared_filepath_.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, file_property);
+  const auto dataset_space     = H5Screate_simple(3, global_shape.data(), nullptr);
+  const auto memory_space      = H5Screate_simple(3, memory_shape.data(), nullptr);
+  const auto dataset           = H5Dcreate2      (file, "data", H5T_NATIVE_FLOAT, dataset_space, H5P_DEFAULT, create_property, H5P_DEFAULT);
+  H5Sselect_hyperslab(dataset_space, H5S_SELECT_SET, file_offset  .data(), nullptr, block_shape.data(), nullptr);
+  H5Sselect_hyperslab(memory_space , H5S_SELECT_SET, memory_offset.data(), nullptr, block_shape.data(), nullptr);
+  H5Dwrite(dataset, H5T_NATIVE_FLOAT, memory_space, dataset_space, transfer_property, scalar_field.data.data());
+  H5Sclose(memory_space     );
+  H5Sclose(dataset_space    );
+  H5Dclose(dataset          );
+  H5Fclose(file             );
+  H5Pclose(transfer_property);
+  H5Pclose(create_property  );
+  H5Pclose(file_property    );
+
+  if (communicator.rank() != 0)
+    return;
+
+  auto xdmf = xdmf_body_volume;
+  boost::replace_all(xdmf, "$FILEPATH"    , std::filesystem::path(shared_filepath_).filename().string());
+  boost::replace_all(xdmf, "$DATASET_NAME", "data");
+  boost::replace_all(xdmf, "$SIZE"        , std::to_string(global_shape         [0]) + " " + std::to_string(global_shape         [1]) + " " + std::to_string(global_shape         [2]));
+  boost::replace_all(xdmf, "$ORIGIN"      , "0 0 0");
+  boost::replace_all(xdmf, "$SPACING"     , std::to_string(scalar_field.spacing [0]) + " " + std::to_string(scalar_field.spacing [1]) + " " + std::to_string(scalar_field.spacing [2]));
+
+  std::ofstream stream(shared_filepath_ + ".xdmf");
+  stream << xdmf_header << xdmf << xdmf_footer;
+}
+}
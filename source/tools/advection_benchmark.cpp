@@ -0,0 +1,124 @@
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/mpi/collectives.hpp>
+#include <boost/mpi/environment.hpp>
+
+#include <dpa/benchmark/benchmark.hpp>
+#include <dpa/stages/domain_partitioner.hpp>
+#include <dpa/stages/particle_advector.hpp>
+
+#undef min
+#undef max
+
+// Benchmarks the cell_stepping integrator against runge_kutta_4 (each with its own step size) on a synthetic vortex of
+// SIZE x SIZE x 8 cells partitioned across the ranks, recording the time of each and the maximum deviation (in cells)
+// of the particles after the duration from a reference, traced by cell_stepping with a tenth of the smaller step size.
+// Run as `mpiexec -n [NUMBER_OF_RANKS] ./advection_benchmark [SIZE] [PARTICLES] [DURATION] [CELL_STEPPING_STEP_SIZE]
+// [RUNGE_KUTTA_4_STEP_SIZE] [ITERATIONS] [OUTPUT_CSV]`.
+std::int32_t main(std::int32_t argc, char** argv)
+{
+  boost::mpi::environment environment(argc, argv);
+  if (argc < 8)
+  {
+    std::cout << "Usage: advection_benchmark [SIZE] [PARTICLES] [DURATION] [CELL_STEPPING_STEP_SIZE] [RUNGE_KUTTA_4_STEP_SIZE] [ITERATIONS] [OUTPUT_CSV]\n";
+    return 1;
+  }
+
+  const auto size                    = static_cast<std::size_t>(std::stoull(argv[1]));
+  const auto particle_count          = static_cast<std::size_t>(std::stoull(argv[2]));
+  const auto duration                = static_cast<dpa::scalar>(std::stod  (argv[3]));
+  const auto cell_stepping_step_size = static_cast<dpa::scalar>(std::stod  (argv[4]));
+  const auto runge_kutta_4_step_size = static_cast<dpa::scalar>(std::stod  (argv[5]));
+  const auto iterations              = static_cast<std::size_t>(std::stoull(argv[6]));
+  const auto filepath                = std::string(argv[7]);
+
+  dpa::domain_partitioner partitioner;
+  partitioner.set_domain_size(dpa::svector3(size, size, 8), dpa::svector3::Ones());
+  const auto& partition    = partitioner.partitions().at(dpa::center);
+  const auto& communicator = *partitioner.cartesian_communicator();
+
+  // A vortex with a faster core and an oscillating drift along Z.
+  const auto shape  = std::array<std::size_t, 3> {partition.ghosted_block_size[0], partition.ghosted_block_size[1], partition.ghosted_block_size[2]};
+  const auto center = dpa::scalar(size) / 2;
+  dpa::particle_advector::vector_field_map vector_fields;
+  auto& vector_field = vector_fields.emplace(dpa::center, dpa::regular_vector_field_3d(shape, partition.ghosted_offset.cast<dpa::scalar>(), dpa::vector3(shape[0], shape[1], shape[2]), dpa::vector3::Ones())).first->second;
+  vector_field.apply([&] (const dpa::regular_vector_field_3d::index_type& index, dpa::vector3& element)
+  {
+    const auto x = dpa::scalar(partition.ghosted_offset[0] + index[0]) - center;
+    const auto y = dpa::scalar(partition.ghosted_offset[1] + index[1]) - center;
+    const auto w = dpa::scalar(0.05) + dpa::scalar(0.2) * std::exp(-(x * x + y * y) / (center * center / 5));
+    element = dpa::vector3(-y * w, x * w, dpa::scalar(0.02) * std::sin(x / 5));
+  });
+
+  // Seeds within an annulus around the vortex, each on the rank owning it. The id identifies the particle across runs.
+  auto seeds     = dpa::particle_advector::particle_vector();
+  auto generator = std::mt19937(0);
+  auto radius    = std::uniform_real_distribution<dpa::scalar>(center / 8, center * 3 / 4);
+  auto angle     = std::uniform_real_distribution<dpa::scalar>(0, 2 * std::acos(dpa::scalar(-1)));
+  for (std::size_t i = 0; i < particle_count; ++i)
+  {
+    const auto r        = radius(generator);
+    const auto a        = angle (generator);
+    const auto position = dpa::vector3(center + r * std::cos(a), center + r * std::sin(a), 4);
+    auto owned = true;
+    for (auto j = 0; j < 3; ++j)
+      owned &= position[j] >= dpa::scalar(partition.offset[j]) && position[j] < dpa::scalar(partition.offset[j] + partitioner.block_size()[j]);
+    if (owned)
+    {
+      seeds.emplace_back(position, 0, dpa::center);
+      seeds.back().id = i;
+    }
+  }
+
+  // Advects the seeds for the duration, returning the final positions of all particles (by id) on every rank.
+  const auto advect = [&] (const std::string& integrator, const dpa::scalar step_size)
+  {
+    auto particles = seeds;
+    for (auto& particle : particles)
+      particle.remaining_iterations = static_cast<dpa::size>(std::round(duration / step_size));
+
+    dpa::particle_advector advector(&partitioner, particle_count, "none", integrator, step_size, false, false);
+    const auto output = advector.advect(vector_fields, particles);
+
+    std::vector<dpa::scalar> local(3 * particle_count, dpa::scalar(0)), global(3 * particle_count);
+    for (auto& particle : output.inactive_particles)
+      for (auto j = 0; j < 3; ++j)
+        local[3 * particle.id + j] = particle.position[j];
+    boost::mpi::all_reduce(communicator, local.data(), static_cast<std::int32_t>(local.size()), global.data(), std::plus<dpa::scalar>());
+    return global;
+  };
+  const auto maximum_deviation = [&] (const std::vector<dpa::scalar>& positions, const std::vector<dpa::scalar>& reference)
+  {
+    auto maximum = dpa::scalar(0);
+    for (std::size_t i = 0; i < particle_count; ++i)
+      maximum = std::max(maximum, (Eigen::Map<const dpa::vector3>(&positions[3 * i]) - Eigen::Map<const dpa::vector3>(&reference[3 * i])).norm());
+    return maximum;
+  };
+
+  const auto reference = advect("cell_stepping", std::min(cell_stepping_step_size, runge_kutta_4_step_size) / 10);
+
+  auto session = dpa::run_mpi<float, std::milli>([&] (dpa::session_recorder<float, std::milli>& recorder)
+  {
+    std::vector<dpa::scalar> positions;
+    recorder.record("cell_stepping_time", [&] ()
+    {
+      positions = advect("cell_stepping", cell_stepping_step_size);
+    });
+    recorder.set   ("cell_stepping_maximum_deviation", maximum_deviation(positions, reference));
+    recorder.record("runge_kutta_4_time", [&] ()
+    {
+      positions = advect("runge_kutta_4", runge_kutta_4_step_size);
+    });
+    recorder.set   ("runge_kutta_4_maximum_deviation", maximum_deviation(positions, reference));
+  }, iterations);
+
+  session.gather();
+  session.to_csv(filepath);
+  return 0;
+}
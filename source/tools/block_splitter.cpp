@@ -0,0 +1,123 @@
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/mpi/environment.hpp>
+#include <boost/mpi.hpp>
+#include <hdf5.h>
+#include <nlohmann/json.hpp>
+
+#include <dpa/stages/argument_parser.hpp>
+#include <dpa/stages/domain_partitioner.hpp>
+#include <dpa/stages/regular_grid_loader.hpp>
+
+// Splits the input dataset of a configuration into one block file per rank plus a manifest.json, which can then be
+// specified as the input_dataset_filepath of the pipeline (see regular_grid_loader). Any number of ranks may read it.
+// Run as `mpiexec -n [NUMBER_OF_BLOCKS] ./block_splitter [PATH_TO_CONFIG_FILE] [OUTPUT_DIRECTORY] [hdf5|raw]`.
+std::int32_t main(std::int32_t argc, char** argv)
+{
+  boost::mpi::environment environment(argc, argv);
+  if (argc < 3)
+  {
+    std::cout << "Usage: block_splitter [PATH_TO_CONFIG_FILE] [OUTPUT_DIRECTORY] [hdf5|raw]\n";
+    return 1;
+  }
+
+  const auto arguments        = dpa::argument_parser::parse(argv[1]);
+  const auto output_directory = std::filesystem::path(argv[2]);
+  const auto format           = argc > 3 ? std::string(argv[3]) : std::string("hdf5");
+
+  auto partitioner = dpa::domain_partitioner ();
+  auto loader      = dpa::regular_grid_loader(
+    &partitioner                           ,
+    arguments.input_dataset_filepath       ,
+    arguments.input_dataset_name           ,
+    arguments.input_dataset_spacing_name   ,
+    arguments.input_dataset_axis_order     ,
+    arguments.input_dataset_component_order);
+
+  // Blocks are written without ghost cells, the loader of the pipeline assembles ghosted blocks from them.
+  partitioner.set_domain_size(loader.load_dimensions(), dpa::svector3::Zero());
+  const auto  vector_fields = loader.load_vector_fields(false);
+  const auto& vector_field  = vector_fields.at(dpa::center);
+  const auto& partition     = partitioner.partitions().at(dpa::center);
+  const auto& block_size    = partition.ghosted_block_size;
+
+  std::error_code error; // Directory creation may race between ranks.
+  std::filesystem::create_directories(output_directory, error);
+
+  const auto filename =
+    std::filesystem::path(arguments.input_dataset_filepath).stem().string() +
+    ".block_" + std::to_string(partition.multi_rank[0]) + "_" + std::to_string(partition.multi_rank[1]) + "_" + std::to_string(partition.multi_rank[2]) +
+    (format == "raw" ? ".raw" : ".h5");
+  const auto filepath = (output_directory / filename).string();
+
+  if (format == "raw")
+  {
+    std::ofstream stream(filepath, std::ios::binary | std::ios::trunc);
+    stream.write(reinterpret_cast<const char*>(vector_field.data.data()), vector_field.data.num_elements() * sizeof(dpa::vector3));
+  }
+  else
+  {
+    const std::array<hsize_t, 4> dataset_size {hsize_t(block_size[0]), hsize_t(block_size[1]), hsize_t(block_size[2]), 3};
+    const hsize_t                spacing_size (3);
+
+    const auto file          = H5Fcreate       (filepath.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+    const auto link_property = H5Pcreate       (H5P_LINK_CREATE);
+    H5Pset_create_intermediate_group(link_property, 1);
+    const auto dataset_space = H5Screate_simple(4, dataset_size.data(), nullptr);
+    const auto spacing_space = H5Screate_simple(1, &spacing_size      , nullptr);
+    const auto dataset       = H5Dcreate2      (file, arguments.input_dataset_name        .c_str(), H5T_NATIVE_FLOAT, dataset_space, link_property, H5P_DEFAULT, H5P_DEFAULT);
+    const auto spacing       = H5Acreate2      (file, arguments.input_dataset_spacing_name.c_str(), H5T_NATIVE_FLOAT, spacing_space, H5P_DEFAULT  , H5P_DEFAULT);
+    H5Dwrite(dataset, H5T_NATIVE_FLOAT, dataset_space, dataset_space, H5P_DEFAULT, vector_field.data.data()->data());
+    H5Awrite(spacing, H5T_NATIVE_FLOAT, vector_field.spacing.data());
+    H5Aclose(spacing      );
+    H5Dclose(dataset      );
+    H5Sclose(spacing_space);
+    H5Sclose(dataset_space);
+    H5Pclose(link_property);
+    H5Fclose(file         );
+  }
+
+  // Gather the multi ranks, offsets and sizes of all blocks to write the manifest.
+  const auto& communicator = *partitioner.cartesian_communicator();
+  const std::array<std::size_t, 9> local_block
+  {
+    std::size_t(partition.multi_rank[0]), std::size_t(partition.multi_rank[1]), std::size_t(partition.multi_rank[2]),
+    partition.offset[0], partition.offset[1], partition.offset[2],
+    block_size      [0], block_size      [1], block_size      [2]
+  };
+  std::vector<std::size_t> blocks;
+  boost::mpi::gather(communicator, local_block.data(), static_cast<int>(local_block.size()), blocks, 0);
+
+  if (communicator.rank() == 0)
+  {
+    nlohmann::json manifest;
+    manifest["format"         ] = format;
+    manifest["axis_order"     ] = "xyz"; // The blocks are written normalized.
+    manifest["component_order"] = "xyz";
+    manifest["dimensions"     ] = {partitioner.domain_size()[0], partitioner.domain_size()[1], partitioner.domain_size()[2]};
+    manifest["spacing"        ] = {vector_field.spacing[0], vector_field.spacing[1], vector_field.spacing[2]};
+    manifest["blocks"         ] = nlohmann::json::array();
+    for (std::size_t i = 0; i < blocks.size(); i += local_block.size())
+    {
+      nlohmann::json block;
+      block["filepath"] =
+        std::filesystem::path(arguments.input_dataset_filepath).stem().string() +
+        ".block_" + std::to_string(blocks[i]) + "_" + std::to_string(blocks[i + 1]) + "_" + std::to_string(blocks[i + 2]) +
+        (format == "raw" ? ".raw" : ".h5");
+      block["offset"  ] = {blocks[i + 3], blocks[i + 4], blocks[i + 5]};
+      block["size"    ] = {blocks[i + 6], blocks[i + 7], blocks[i + 8]};
+      manifest["blocks"].push_back(block);
+    }
+
+    std::ofstream stream((output_directory / "manifest.json").string());
+    stream << manifest.dump(2);
+  }
+
+  return 0;
+}
@@ -0,0 +1,89 @@
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/mpi/environment.hpp>
+#include <tbb/tbb.h>
+
+#include <dpa/benchmark/benchmark.hpp>
+#include <dpa/stages/ftle_estimator.hpp>
+#include <dpa/types/regular_fields.hpp>
+
+#undef min
+#undef max
+
+// Benchmarks the grid traversals (apply, gradient, interpolation) and the FTLE estimation on a synthetic cubic vector
+// field, independent of the data loading and advection of the pipeline. Each rank runs on its own field.
+// Run as `mpiexec -n [NUMBER_OF_RANKS] ./grid_benchmark [SIZE] [ITERATIONS] [OUTPUT_CSV]`.
+std::int32_t main(std::int32_t argc, char** argv)
+{
+  boost::mpi::environment environment(argc, argv);
+  if (argc < 4)
+  {
+    std::cout << "Usage: grid_benchmark [SIZE] [ITERATIONS] [OUTPUT_CSV]\n";
+    return 1;
+  }
+
+  const auto size       = static_cast<std::size_t>(std::stoull(argv[1]));
+  const auto iterations = static_cast<std::size_t>(std::stoull(argv[2]));
+  const auto filepath   = std::string(argv[3]);
+
+  auto vector_field = dpa::regular_vector_field_3d({size, size, size}, dpa::vector3::Zero(), dpa::vector3::Constant(size - 1), dpa::vector3::Ones());
+  vector_field.apply([&] (const dpa::regular_vector_field_3d::index_type& index, dpa::vector3& element)
+  {
+    element = dpa::vector3(-dpa::scalar(index[1]), dpa::scalar(index[0]), dpa::scalar(0.1) * dpa::scalar(index[2]));
+  });
+
+  auto positions = std::vector<dpa::vector3>(size * size * size);
+  auto values    = std::vector<dpa::vector3>(positions.size());
+  auto generator = std::mt19937(0);
+  auto uniform   = std::uniform_real_distribution<dpa::scalar>(0, dpa::scalar(size - 1));
+  for (auto& position : positions)
+    position = dpa::vector3(uniform(generator), uniform(generator), uniform(generator));
+
+#ifdef DPA_FTLE_SUPPORT
+  // A linear flow map (a shear and a stretch), one particle per cell.
+  auto particles = tbb::concurrent_vector<dpa::particle_3d>();
+  for (std::size_t x = 0; x < size; ++x)
+    for (std::size_t y = 0; y < size; ++y)
+      for (std::size_t z = 0; z < size; ++z)
+      {
+        auto& particle = *particles.emplace_back(dpa::vector3(x, y, z), 0, dpa::center, 0);
+        particle.position = dpa::vector3(dpa::scalar(1.5) * x + dpa::scalar(0.5) * y, y, dpa::scalar(0.8) * z);
+      }
+#endif
+
+  auto session = dpa::run_mpi<float, std::milli>([&] (dpa::session_recorder<float, std::milli>& recorder)
+  {
+    recorder.record("apply_time"        , [&] ()
+    {
+      vector_field.apply([&] (const dpa::regular_vector_field_3d::index_type& index, dpa::vector3& element)
+      {
+        element *= dpa::scalar(1);
+      });
+    });
+    recorder.record("gradient_time"     , [&] ()
+    {
+      const auto gradient = vector_field.gradient();
+    });
+    recorder.record("interpolation_time", [&] ()
+    {
+      tbb::parallel_for(std::size_t(0), positions.size(), std::size_t(1), [&] (const std::size_t index)
+      {
+        values[index] = vector_field.interpolate(positions[index]);
+      });
+    });
+#ifdef DPA_FTLE_SUPPORT
+    recorder.record("ftle_estimation_time", [&] ()
+    {
+      const auto ftle_field = dpa::ftle_estimator::estimate(vector_field, 1, dpa::vector3::Ones(), 1, particles);
+    });
+#endif
+  }, iterations);
+
+  session.gather();
+  session.to_csv(filepath);
+  return 0;
+}
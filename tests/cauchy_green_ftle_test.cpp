@@ -0,0 +1,53 @@
+#include "catch.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <Eigen/Eigenvalues>
+
+#include <dpa/math/cauchy_green_ftle.hpp>
+
+#undef min
+#undef max
+
+// The kernel is compiled with -ffast-math (unlike this test), hence its vector math functions are checked against the
+// (double precision) SelfAdjointEigenSolver on the right Cauchy-Green tensors of random gradients.
+TEST_CASE("The FTLE of right Cauchy-Green tensors matches the SelfAdjointEigenSolver", "[cauchy_green_ftle]")
+{
+  constexpr std::size_t count        = 10000;
+  constexpr double      inverse_time = 0.25;
+
+  auto generator = std::mt19937(0);
+  auto normal    = std::normal_distribution<double>(0.0, 1.0);
+
+  std::vector<dpa::scalar> c00(count), c01(count), c02(count), c11(count), c12(count), c22(count), output(count);
+  std::vector<double>      expected(count);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    Eigen::Matrix3d gradient;
+    for (auto j = 0; j < 9; ++j)
+      gradient.data()[j] = normal(generator);
+    const Eigen::Matrix3d tensor = gradient.transpose() * gradient;
+    c00[i] = static_cast<dpa::scalar>(tensor(0, 0)); c01[i] = static_cast<dpa::scalar>(tensor(0, 1)); c02[i] = static_cast<dpa::scalar>(tensor(0, 2));
+    c11[i] = static_cast<dpa::scalar>(tensor(1, 1)); c12[i] = static_cast<dpa::scalar>(tensor(1, 2)); c22[i] = static_cast<dpa::scalar>(tensor(2, 2));
+    expected[i] = 0.5 * std::log(Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d>(tensor, Eigen::EigenvaluesOnly).eigenvalues()[2]) * inverse_time;
+  }
+
+  dpa::cauchy_green_ftle(c00.data(), c01.data(), c02.data(), c11.data(), c12.data(), c22.data(), count, dpa::scalar(inverse_time), output.data());
+  for (std::size_t i = 0; i < count; ++i)
+    REQUIRE(std::abs(output[i] - expected[i]) <= 1e-5);
+}
+
+TEST_CASE("The FTLE of degenerate right Cauchy-Green tensors is finite", "[cauchy_green_ftle]")
+{
+  const std::vector<dpa::scalar> zero(2, 0), one {1, 4};
+  std::vector<dpa::scalar> output(2);
+  dpa::cauchy_green_ftle(one.data(), zero.data(), zero.data(), one.data(), zero.data(), one.data(), 2, 1, output.data());
+  REQUIRE(std::abs(output[0]) <= 1e-6);
+  REQUIRE(std::abs(output[1] - std::log(dpa::scalar(2))) <= 1e-6);
+
+  dpa::cauchy_green_ftle(zero.data(), zero.data(), zero.data(), zero.data(), zero.data(), zero.data(), 2, 1, output.data());
+  REQUIRE(std::isfinite(output[0]));
+  REQUIRE(output[0] < -40);
+}
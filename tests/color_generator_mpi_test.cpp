@@ -0,0 +1,67 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <boost/mpi/collectives.hpp>
+#include <boost/mpi/environment.hpp>
+
+#include <dpa/stages/color_generator.hpp>
+#include <dpa/stages/domain_partitioner.hpp>
+
+#undef min
+#undef max
+
+static boost::mpi::environment environment;
+
+// The gradient of phi(x, y, z) = x^2 / 2 + xy + y^2 + xz + 0.3 z^2, which the trapezoidal rule integrates exactly.
+static dpa::scalar phi(const dpa::vector3& x)
+{
+  return x[0] * x[0] / 2 + x[0] * x[1] + x[1] * x[1] + x[0] * x[2] + dpa::scalar(0.3) * x[2] * x[2];
+}
+
+TEST_CASE("Potentials are continuous across ranks", "[color_generator]")
+{
+  const auto spacing = dpa::vector3(0.5, 0.25, 0.5);
+
+  dpa::domain_partitioner partitioner;
+  partitioner.set_domain_size(dpa::svector3(20, 12, 16), dpa::svector3::Ones());
+
+  const auto& partition = partitioner.partitions().at(dpa::center);
+  const auto  shape     = std::array<std::size_t, 3> {partition.ghosted_block_size[0], partition.ghosted_block_size[1], partition.ghosted_block_size[2]};
+  const auto  offset    = dpa::vector3(partition.ghosted_offset.cast<dpa::scalar>().cwiseProduct(spacing));
+
+  std::unordered_map<dpa::relative_direction, dpa::regular_vector_field_3d> vector_fields;
+  auto& vector_field = vector_fields.emplace(dpa::center, dpa::regular_vector_field_3d(shape, offset, dpa::vector3(dpa::vector3(shape[0], shape[1], shape[2]).cwiseProduct(spacing)), spacing)).first->second;
+  vector_field.apply([&] (const dpa::regular_vector_field_3d::index_type& index, dpa::vector3& element)
+  {
+    const dpa::vector3 x = offset + dpa::vector3(index[0], index[1], index[2]).cwiseProduct(spacing);
+    element = dpa::vector3(x[0] + x[1] + x[2], x[0] + 2 * x[1], x[0] + dpa::scalar(0.6) * x[2]);
+  });
+
+  // One vertex per node of the block.
+  dpa::integral_curves integral_curves(1);
+  auto& vertices = integral_curves[0].vertices;
+  for (std::size_t x = 0; x < shape[0]; ++x)
+    for (std::size_t y = 0; y < shape[1]; ++y)
+      for (std::size_t z = 0; z < shape[2]; ++z)
+        vertices.push_back(offset + dpa::vector3(x, y, z).cwiseProduct(spacing));
+
+  dpa::color_generator::generate_from_potentials(integral_curves, vector_fields, &partitioner);
+
+  // Reduced before requiring, such that a failure on one rank does not leave the others waiting.
+  const auto& colors     = std::get<std::vector<dpa::scalar>>(integral_curves[0].colors);
+  std::size_t checked    = 0;
+  std::size_t mismatched = 0;
+  for (std::size_t i = 0; i < vertices.size(); ++i)
+  {
+    if (!vector_field.contains(vertices[i]))
+      continue;
+    if (std::abs(colors[i] - phi(vertices[i])) > dpa::scalar(1e-4) * std::max(dpa::scalar(1), std::abs(phi(vertices[i]))))
+      ++mismatched;
+    ++checked;
+  }
+  const auto& communicator = *partitioner.cartesian_communicator();
+  REQUIRE(boost::mpi::all_reduce(communicator, mismatched, std::plus<std::size_t>()) == 0);
+  REQUIRE(boost::mpi::all_reduce(communicator, checked   , std::plus<std::size_t>()) >  0);
+}
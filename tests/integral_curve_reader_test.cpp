@@ -0,0 +1,124 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <boost/mpi/environment.hpp>
+
+#include <dpa/stages/domain_partitioner.hpp>
+#include <dpa/stages/integral_curve_reader.hpp>
+#include <dpa/stages/integral_curve_saver.hpp>
+
+#undef min
+#undef max
+
+static boost::mpi::environment environment;
+
+// Saves a curve of straight polylines (more than one spatial chunk of vertices) with a spatial index, reads a query box
+// back and requires it to return exactly the polylines intersecting the box, with their vertices, colors and indices.
+TEST_CASE("Spatially indexed curves round-trip through the reader", "[integral_curve_reader]")
+{
+  constexpr std::size_t polyline_count = 8000;
+  constexpr std::size_t polyline_size  = 50; // Vertices, excluding the terminal one.
+
+  // Each vertex is colored by its polyline and position within it, which identifies it after sorting.
+  auto generator = std::mt19937(0);
+  auto uniform   = std::uniform_real_distribution<dpa::scalar>(0, 100);
+  auto direction = std::uniform_real_distribution<dpa::scalar>(-0.2f, 0.2f);
+
+  dpa::integral_curve curve {dpa::integral_curve::vertex_vector(dpa::allocator<dpa::vector3>(dpa::allocation_policy {true, false}))};
+  std::vector<dpa::scalar>   colors ;
+  std::vector<std::uint32_t> indices;
+  std::vector<std::vector<dpa::vector3>> polylines(polyline_count);
+  for (std::size_t i = 0; i < polyline_count; ++i)
+  {
+    const dpa::vector3 start(uniform(generator), uniform(generator), uniform(generator));
+    const dpa::vector3 step (direction(generator), direction(generator), direction(generator));
+    for (std::size_t j = 0; j < polyline_size; ++j)
+    {
+      if (j > 0)
+        indices.insert(indices.end(), {static_cast<std::uint32_t>(curve.vertices.size() - 1), static_cast<std::uint32_t>(curve.vertices.size())});
+      polylines[i].push_back(start + dpa::scalar(j) * step);
+      curve.vertices.push_back(polylines[i].back());
+      colors        .push_back(dpa::scalar(i * polyline_size + j));
+    }
+    curve.vertices.push_back(dpa::terminal_value<dpa::vector3>());
+    colors        .push_back(dpa::scalar(-1));
+  }
+  curve.colors  = colors ;
+  curve.indices = indices;
+  REQUIRE(curve.vertices.size() > dpa::spatial_chunk_vertices);
+
+  const auto filepath = (std::filesystem::temp_directory_path() / "integral_curve_reader_test.h5").string();
+  dpa::domain_partitioner partitioner;
+  partitioner.set_domain_size(dpa::svector3(100, 100, 100), dpa::svector3::Ones());
+  dpa::integral_curve_saver saver(&partitioner, filepath, "none", std::nullopt, true);
+  saver.save(dpa::integral_curves {curve});
+
+  dpa::integral_curve_reader reader(std::filesystem::path(filepath).replace_extension(".rank_0.h5").string());
+  REQUIRE(reader.curves().size()           == 1);
+  REQUIRE(reader.curves()[0].chunks.size() >  1);
+
+  // Beyond the first chunk, such that the indices of the read chunks are rebased.
+  const auto&      first_chunk = reader.curves()[0].chunks[0];
+  const dpa::aabb3 box(dpa::vector3::Constant(60).transpose(), dpa::vector3::Constant(80).transpose());
+  REQUIRE(!dpa::aabb3(first_chunk.minimum.transpose(), first_chunk.maximum.transpose()).intersects(box));
+  const auto read_curves = reader.read(box);
+  REQUIRE(read_curves.size() == 1);
+
+  const auto& read_curve   = read_curves[0];
+  const auto& read_colors  = std::get<std::vector<dpa::scalar>>  (read_curve.colors );
+  const auto& read_indices = std::get<std::vector<std::uint32_t>>(read_curve.indices);
+  REQUIRE(read_colors.size() == read_curve.vertices.size());
+
+  // Complete polylines, identified by the color of their first vertex.
+  std::map<std::size_t, std::size_t> read_polylines; // Polyline to its first vertex in the read curve.
+  for (std::size_t begin = 0; begin < read_curve.vertices.size(); begin += polyline_size + 1)
+  {
+    const auto polyline = static_cast<std::size_t>(read_colors[begin]) / polyline_size;
+    REQUIRE(read_polylines.emplace(polyline, begin).second);
+    for (std::size_t j = 0; j < polyline_size; ++j)
+    {
+      REQUIRE(read_curve.vertices[begin + j] == polylines[polyline][j]);
+      REQUIRE(read_colors        [begin + j] == dpa::scalar(polyline * polyline_size + j));
+    }
+    REQUIRE(read_curve.vertices[begin + polyline_size] == dpa::terminal_value<dpa::vector3>());
+  }
+
+  // Every polyline intersecting the box is read, and only those of the chunks intersecting it.
+  std::size_t intersecting = 0;
+  for (std::size_t i = 0; i < polyline_count; ++i)
+  {
+    dpa::aabb3 bounds;
+    for (auto& vertex : polylines[i])
+      bounds.extend(vertex.transpose());
+    if (bounds.intersects(box))
+    {
+      REQUIRE(read_polylines.count(i) == 1);
+      ++intersecting;
+    }
+  }
+  REQUIRE(intersecting          > 0);
+  REQUIRE(read_polylines.size() < polyline_count);
+
+  // Indices are rebased onto the read vertices: the consecutive vertices of each polyline.
+  REQUIRE(read_indices.size() == read_polylines.size() * (polyline_size - 1) * 2);
+  std::vector<bool> covered(read_curve.vertices.size(), false);
+  for (std::size_t i = 0; i < read_indices.size(); i += 2)
+  {
+    REQUIRE(read_indices[i + 1] <  read_curve.vertices.size());
+    REQUIRE(read_indices[i + 1] == read_indices[i] + 1);
+    REQUIRE(read_curve.vertices[read_indices[i + 1]] != dpa::terminal_value<dpa::vector3>());
+    REQUIRE(read_colors[read_indices[i + 1]] == read_colors[read_indices[i]] + 1);
+    covered[read_indices[i + 1]] = true;
+  }
+  for (auto& [polyline, begin] : read_polylines)
+    for (std::size_t j = 1; j < polyline_size; ++j)
+      REQUIRE(covered[begin + j]);
+
+  std::filesystem::remove(std::filesystem::path(filepath).replace_extension(".rank_0.h5"));
+  std::filesystem::remove(std::filesystem::path(filepath).replace_extension(".rank_0.h5").string() + ".xdmf");
+}
@@ -0,0 +1,94 @@
+#include "catch.hpp"
+
+#include <cmath>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/mpi/collectives.hpp>
+#include <boost/mpi/environment.hpp>
+
+#include <dpa/stages/domain_partitioner.hpp>
+#include <dpa/stages/particle_advector.hpp>
+
+#undef min
+#undef max
+
+static boost::mpi::environment environment;
+
+// The triangle wave through 0 at the even and 1 at the odd nodes, i.e. the linear interpolation of its node values, and
+// its integral from 0.
+static dpa::scalar triangle_wave         (const dpa::scalar x)
+{
+  const auto r = x - 2 * std::floor(x / 2);
+  return r <= 1 ? r : 2 - r;
+}
+static dpa::scalar triangle_wave_integral(const dpa::scalar x)
+{
+  const auto k = std::floor(x / 2);
+  const auto r = x - 2 * k;
+  return k + (r <= 1 ? r * r / 2 : 1 - (2 - r) * (2 - r) / 2);
+}
+
+// Seeds a particle at each node of the block of the rank (stride 1, i.e. also at the last node of each block) which
+// stays within the loaded domain, advects them by the integrator through the field (1, shear * triangle_wave(x), 0) and requires
+// all of them to complete their iterations at the exact position.
+static void check_advection(const std::string& integrator, const dpa::scalar step_size, const std::size_t iterations, const dpa::scalar shear)
+{
+  dpa::domain_partitioner partitioner;
+  partitioner.set_domain_size(dpa::svector3(32, 8, 8), dpa::svector3::Ones());
+
+  const auto& partition = partitioner.partitions().at(dpa::center);
+  const auto  shape     = std::array<std::size_t, 3> {partition.ghosted_block_size[0], partition.ghosted_block_size[1], partition.ghosted_block_size[2]};
+
+  dpa::particle_advector::vector_field_map vector_fields;
+  auto& vector_field = vector_fields.emplace(dpa::center, dpa::regular_vector_field_3d(shape, partition.ghosted_offset.cast<dpa::scalar>(), dpa::vector3(shape[0], shape[1], shape[2]), dpa::vector3::Ones())).first->second;
+  vector_field.apply([&] (const dpa::regular_vector_field_3d::index_type& index, dpa::vector3& element)
+  {
+    element = dpa::vector3(1, shear * triangle_wave(dpa::scalar(partition.ghosted_offset[0] + index[0])), 0);
+  });
+
+  // The last loaded node of the domain (which depends on the partitioning) is not interpolable, and the shear displaces
+  // the particles by at most 2 in y.
+  const auto& communicator = *partitioner.cartesian_communicator();
+  dpa::svector3 last_node;
+  for (auto i = 0; i < 3; ++i)
+    last_node[i] = boost::mpi::all_reduce(communicator, partition.ghosted_offset[i] + partition.ghosted_block_size[i] - 1, boost::mpi::maximum<std::size_t>());
+
+  const auto duration = step_size * iterations;
+  std::vector<dpa::particle_3d> particles;
+  for (auto x = partition.offset[0]; x < partition.offset[0] + partitioner.block_size()[0] && x + duration < last_node[0]; ++x)
+    for (auto y = partition.offset[1]; y < partition.offset[1] + partitioner.block_size()[1] && y + 2        < last_node[1]; ++y)
+      for (auto z = partition.offset[2]; z < partition.offset[2] + partitioner.block_size()[2] && z            < last_node[2]; ++z)
+      {
+        particles.emplace_back(dpa::vector3(x, y, z), iterations, dpa::center);
+        particles.back().id = (x * 8 + y) * 8 + z;
+      }
+  const auto seed_count = particles.size();
+
+  dpa::particle_advector advector(&partitioner, 1000, "none", integrator, step_size, false, false);
+  const auto output = advector.advect(vector_fields, particles);
+
+  // Reduced before requiring, such that a failure on one rank does not leave the others waiting.
+  std::size_t mismatched = 0;
+  for (auto& particle : output.inactive_particles)
+  {
+    const dpa::vector3 seed    (dpa::scalar(particle.id / 64), dpa::scalar(particle.id / 8 % 8), dpa::scalar(particle.id % 8));
+    const dpa::vector3 expected(seed[0] + duration, seed[1] + shear * (triangle_wave_integral(seed[0] + duration) - triangle_wave_integral(seed[0])), seed[2]);
+    if (particle.remaining_iterations != 0 || (particle.position - expected).norm() > dpa::scalar(1e-3))
+      ++mismatched;
+  }
+
+  REQUIRE(boost::mpi::all_reduce(communicator, mismatched                       , std::plus<std::size_t>()) == 0);
+  REQUIRE(boost::mpi::all_reduce(communicator, output.inactive_particles.size(), std::plus<std::size_t>()) == boost::mpi::all_reduce(communicator, seed_count, std::plus<std::size_t>()));
+}
+
+TEST_CASE("Particles on the last node of a block are handed over", "[particle_advector]")
+{
+  check_advection("euler", 1, 4, 0);
+}
+TEST_CASE("Cell stepping continues steps beyond the ghosted block on the neighbor", "[particle_advector]")
+{
+  check_advection("cell_stepping", 3, 4, dpa::scalar(0.25));
+}
@@ -0,0 +1,53 @@
+#include "catch.hpp"
+
+#include <cmath>
+#include <random>
+
+#include <Eigen/Eigenvalues>
+
+#include <dpa/math/symmetric_eigenvalues.hpp>
+
+#undef min
+#undef max
+
+// The largest eigenvalue of a right Cauchy-Green tensor (the Gram matrix of the columns of a random gradient), scaled by
+// the given magnitude, against the (double precision) SelfAdjointEigenSolver.
+static void check_gram_matrices(const double magnitude, const std::size_t count)
+{
+  auto generator = std::mt19937(0);
+  auto normal    = std::normal_distribution<double>(0.0, 1.0);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    Eigen::Matrix3d gradient;
+    for (auto j = 0; j < 9; ++j)
+      gradient.data()[j] = normal(generator);
+    const Eigen::Matrix3d tensor   = magnitude * gradient.transpose() * gradient;
+    const auto            expected = Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d>(tensor, Eigen::EigenvaluesOnly).eigenvalues()[2];
+    const auto            actual   = dpa::largest_symmetric_eigenvalue(
+      static_cast<dpa::scalar>(tensor(0, 0)), static_cast<dpa::scalar>(tensor(0, 1)), static_cast<dpa::scalar>(tensor(0, 2)),
+      static_cast<dpa::scalar>(tensor(1, 1)), static_cast<dpa::scalar>(tensor(1, 2)), static_cast<dpa::scalar>(tensor(2, 2)));
+    REQUIRE(std::isfinite(actual));
+    REQUIRE(std::abs(actual - expected) <= 1e-5 * expected);
+  }
+}
+
+TEST_CASE("Largest symmetric eigenvalue matches the SelfAdjointEigenSolver", "[symmetric_eigenvalues]")
+{
+  check_gram_matrices(1.0, 100000);
+}
+
+TEST_CASE("Largest symmetric eigenvalue neither overflows nor underflows", "[symmetric_eigenvalues]")
+{
+  check_gram_matrices(1e30 , 10000);
+  check_gram_matrices(1e-30, 10000);
+}
+
+// A repeated largest eigenvalue (r = -1) is ill-conditioned in r, hence only accurate to about the square root of the
+// epsilon (e.g. with the vector math functions of -ffast-math).
+TEST_CASE("Largest symmetric eigenvalue of degenerate tensors", "[symmetric_eigenvalues]")
+{
+  REQUIRE(dpa::largest_symmetric_eigenvalue(0, 0, 0, 0, 0, 0) == 0);
+  REQUIRE(std::abs(dpa::largest_symmetric_eigenvalue(4, 0, 0, 4, 0, 4) - 4) <= 1e-5 * 4);
+  REQUIRE(std::abs(dpa::largest_symmetric_eigenvalue(1, 0, 0, 1, 0, 9) - 9) <= 1e-5 * 9);
+  REQUIRE(std::abs(dpa::largest_symmetric_eigenvalue(9, 0, 0, 9, 0, 1) - 9) <= 1e-3 * 9);
+}